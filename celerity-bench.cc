@@ -0,0 +1,9 @@
+#include "common.h"
+
+// Entry point of the single celerity-bench executable. The benchmark suites are
+// linked in from the individual sources and register themselves via BENCHMARK_MAIN.
+int main(int argc, char** argv) {
+  BenchmarkApp app(argc, argv);
+  BenchmarkRegistry::getInstance().runAll(app);
+  return app.getExitCode();
+}
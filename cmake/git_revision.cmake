@@ -0,0 +1,13 @@
+# Writes the git revision of SOURCE_DIR into OUTPUT. Runs on every build, but
+# configure_file() only touches OUTPUT when the revision has changed.
+execute_process(
+  COMMAND git rev-parse --short HEAD
+  WORKING_DIRECTORY ${SOURCE_DIR}
+  OUTPUT_VARIABLE BENCH_GIT_REVISION
+  OUTPUT_STRIP_TRAILING_WHITESPACE
+  ERROR_QUIET
+)
+if(NOT BENCH_GIT_REVISION)
+  set(BENCH_GIT_REVISION "unknown")
+endif()
+configure_file(${SOURCE_DIR}/cmake/git_revision.h.in ${OUTPUT} @ONLY)
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Timing samples of an earlier run, loaded from the CSV output of
+ * AppendingCsvResultConsumer or the records of JsonLinesResultConsumer,
+ * indexed by benchmark name and problem size. If the file contains several
+ * results for the same benchmark, the last one wins. Lines that cannot be
+ * parsed are skipped with a warning.
+ */
+class Baseline
+{
+public:
+  Baseline(const std::string& filename) {
+    std::ifstream input{filename};
+    if(!input) {
+      throw std::invalid_argument{"Could not open baseline " + filename};
+    }
+
+    std::vector<std::string> columns;
+    std::string line;
+    for(std::size_t line_number = 1; std::getline(input, line); ++line_number) {
+      if(line.empty()) continue;
+      const auto warn = [&](const std::string& reason) {
+        std::cerr << "Warning: skipping line " << line_number << " of baseline " << filename << ": " << reason
+                  << std::endl;
+      };
+      if(line[0] == '{') {
+        if(const auto error = addJsonRecord(line); !error.empty()) warn(error);
+        continue;
+      }
+      auto fields = split(line, ',');
+      // Every flush of the CSV consumer starts with its own header
+      if(line[0] == '#') {
+        columns = std::move(fields);
+        continue;
+      }
+      if(fields.size() != columns.size()) {
+        warn("expected " + std::to_string(columns.size()) + " fields, got " + std::to_string(fields.size()));
+        continue;
+      }
+
+      Result result;
+      for(std::size_t i = 1; i < fields.size(); ++i) {
+        result[columns[i]] = fields[i];
+      }
+      if(const auto error = addResult(fields[0], result); !error.empty()) warn(error);
+    }
+  }
+
+  // The sorted samples (in seconds) of the given timing, if the baseline contains them
+  std::optional<std::vector<double>> getSamples(
+      const std::string& benchmark, std::size_t problem_size, const std::string& timing) const {
+    const auto it = samples.find({benchmark, problem_size});
+    if(it == samples.end()) return std::nullopt;
+    const auto timing_it = it->second.find(timing);
+    if(timing_it == it->second.end()) return std::nullopt;
+    return timing_it->second;
+  }
+
+  /**
+   * Two-sided p-value of the Mann-Whitney U test that the samples a and b stem from
+   * the same distribution, using the normal approximation with tie correction.
+   */
+  static double mannWhitneyPValue(const std::vector<double>& a, const std::vector<double>& b) {
+    const double n1 = static_cast<double>(a.size());
+    const double n2 = static_cast<double>(b.size());
+    if(a.empty() || b.empty()) return 1.0;
+
+    std::vector<std::pair<double, bool>> all;
+    for(double x : a) all.emplace_back(x, true);
+    for(double x : b) all.emplace_back(x, false);
+    std::sort(all.begin(), all.end());
+
+    // Rank sum of a, assigning tied values their average rank
+    double rankSumA = 0.0;
+    double tieCorrection = 0.0;
+    for(std::size_t i = 0; i < all.size();) {
+      std::size_t j = i;
+      while(j < all.size() && all[j].first == all[i].first) ++j;
+      const double averageRank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2.0;
+      for(std::size_t k = i; k < j; ++k) {
+        if(all[k].second) rankSumA += averageRank;
+      }
+      const double ties = static_cast<double>(j - i);
+      tieCorrection += ties * ties * ties - ties;
+      i = j;
+    }
+
+    const double n = n1 + n2;
+    const double u = rankSumA - n1 * (n1 + 1.0) / 2.0;
+    const double mu = n1 * n2 / 2.0;
+    const double sigma = std::sqrt(n1 * n2 / 12.0 * ((n + 1.0) - tieCorrection / (n * (n - 1.0))));
+    if(sigma <= 0.0) return 1.0;
+
+    // Continuity correction
+    const double z = std::max(std::abs(u - mu) - 0.5, 0.0) / sigma;
+    return std::erfc(z / std::sqrt(2.0));
+  }
+
+private:
+  using Result = std::map<std::string, std::string>;
+
+  std::map<std::pair<std::string, std::size_t>, std::map<std::string, std::vector<double>>> samples;
+
+  // Adds the samples of a result. Returns why the result was rejected, or an empty string.
+  std::string addResult(const std::string& benchmark, const Result& result) {
+    const auto size_it = result.find("problem-size");
+    if(size_it == result.end()) return "no problem size";
+    std::size_t problem_size = 0;
+    if(!parseNumber(size_it->second, problem_size)) return "invalid problem size '" + size_it->second + "'";
+
+    const std::string suffix = "-samples";
+    std::map<std::string, std::vector<double>> timings;
+    for(const auto& [column, value] : result) {
+      if(column.size() <= suffix.size() || column.compare(column.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        continue;
+      }
+      if(value == "N/A") continue;
+      std::string list = value;
+      list.erase(std::remove(list.begin(), list.end(), '"'), list.end());
+      std::vector<double> values;
+      for(const auto& s : split(list, ' ')) {
+        if(s.empty()) continue;
+        double v = 0.0;
+        if(!parseNumber(s, v)) return "invalid sample '" + s + "' in " + column;
+        values.push_back(v);
+      }
+      std::sort(values.begin(), values.end());
+      timings[column.substr(0, column.size() - suffix.size())] = std::move(values);
+    }
+    for(auto& [timing, values] : timings) {
+      samples[{benchmark, problem_size}][timing] = std::move(values);
+    }
+    return "";
+  }
+
+  // Parses all of s as a number, without throwing
+  static bool parseNumber(const std::string& s, double& value) {
+    if(s.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtod(s.c_str(), &end);
+    return errno == 0 && end == s.c_str() + s.size();
+  }
+
+  static bool parseNumber(const std::string& s, std::size_t& value) {
+    if(s.empty() || s.find_first_not_of("0123456789") != std::string::npos) return false;
+    char* end = nullptr;
+    errno = 0;
+    value = static_cast<std::size_t>(std::strtoull(s.c_str(), &end, 10));
+    return errno == 0 && end == s.c_str() + s.size();
+  }
+
+  // Extracts the problem size and the samples from a record written by JsonLinesResultConsumer
+  std::string addJsonRecord(const std::string& line) {
+    static const std::regex benchmark_re{R"re(^\{"benchmark":"((?:[^"\\]|\\.)*)")re"};
+    static const std::regex size_re{R"re("problem-size":\{"value":(\d+))re"};
+    static const std::regex samples_re{R"re("([^"]+-samples)":\{"value":\[([^\]]*)\])re"};
+
+    std::smatch benchmark, size;
+    if(!std::regex_search(line, benchmark, benchmark_re) || !std::regex_search(line, size, size_re)) {
+      return "no benchmark name or problem size";
+    }
+
+    Result result;
+    result["problem-size"] = size[1];
+    for(auto it = std::sregex_iterator(line.begin(), line.end(), samples_re); it != std::sregex_iterator(); ++it) {
+      std::string list = (*it)[2];
+      std::replace(list.begin(), list.end(), ',', ' ');
+      result[(*it)[1]] = list;
+    }
+    return addResult(benchmark[1], result);
+  }
+
+  // Splits at delimiters outside of double quotes. Quotes are removed, "" within quotes yields a literal quote.
+  static std::vector<std::string> split(const std::string& s, char delimiter) {
+    std::vector<std::string> parts;
+    std::string current;
+    bool quoted = false;
+    for(std::size_t i = 0; i < s.size(); ++i) {
+      const char c = s[i];
+      if(c == '"') {
+        if(quoted && i + 1 < s.size() && s[i + 1] == '"') {
+          current += '"';
+          ++i;
+        } else {
+          quoted = !quoted;
+        }
+      } else if(c == delimiter && !quoted) {
+        parts.push_back(std::move(current));
+        current.clear();
+      } else {
+        current += c;
+      }
+    }
+    parts.push_back(std::move(current));
+    return parts;
+  }
+};
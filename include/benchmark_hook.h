@@ -11,6 +11,9 @@ public:
   virtual void postSetup()= 0;
   virtual void preKernel() = 0;
   virtual void postKernel() = 0;
+  // Called by all nodes after the last run, e.g. to reduce measurements onto the master node
+  virtual void gatherResults() {}
+  // Called on the master node only
   virtual void emitResults(ResultConsumer&) {}
 
   virtual ~BenchmarkHook(){}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class BenchmarkApp;
+
+/**
+ * Collects the benchmark suites (the former main() bodies) of all sources linked
+ * into an executable. Each source registers its suite through BENCHMARK_MAIN, so
+ * the same source builds either a standalone binary or a part of the single
+ * celerity-bench executable, which runs every suite with one runtime startup.
+ */
+class BenchmarkRegistry
+{
+public:
+  using Suite = std::function<void(BenchmarkApp&)>;
+
+  static BenchmarkRegistry& getInstance() {
+    static BenchmarkRegistry inst;
+    return inst;
+  }
+
+  void add(const std::string& name, Suite suite) {
+    suites.emplace_back(name, std::move(suite));
+  }
+
+  // Runs all registered suites. Individual benchmarks are filtered by BenchmarkApp::run.
+  void runAll(BenchmarkApp& app) const {
+    for(const auto& [name, suite] : suites) {
+      suite(app);
+    }
+  }
+
+  BenchmarkRegistry(BenchmarkRegistry const&) = delete;
+  void operator=(BenchmarkRegistry const&) = delete;
+
+private:
+  BenchmarkRegistry() {}
+
+  std::vector<std::pair<std::string, Suite>> suites;
+};
+
+struct BenchmarkRegistration
+{
+  BenchmarkRegistration(const std::string& name, BenchmarkRegistry::Suite suite) {
+    BenchmarkRegistry::getInstance().add(name, std::move(suite));
+  }
+};
+
+// The single executable provides its own main() (see celerity-bench.cc)
+#ifdef CELERITY_BENCH_SINGLE_EXECUTABLE
+  #define BENCHMARK_DEFINE_MAIN
+#else
+  #define BENCHMARK_DEFINE_MAIN                                                                                      \
+    int main(int argc, char** argv) {                                                                                \
+      BenchmarkApp app(argc, argv);                                                                                  \
+      BenchmarkRegistry::getInstance().runAll(app);                                                                  \
+      return app.getExitCode();                                                                                      \
+    }
+#endif
+
+/**
+ * Defines and registers the benchmark suite of a source file, e.g.
+ *
+ *   BENCHMARK_MAIN(gemm, app) {
+ *     app.run<Gemm>();
+ *   }
+ */
+#define BENCHMARK_MAIN(suite, app)                                                                                   \
+  static void benchmark_suite_##suite(BenchmarkApp&);                                                                \
+  static BenchmarkRegistration benchmark_registration_##suite{#suite, &benchmark_suite_##suite};                     \
+  BENCHMARK_DEFINE_MAIN                                                                                              \
+  static void benchmark_suite_##suite(BenchmarkApp& app)
@@ -8,17 +8,6 @@ inline namespace cl {
 namespace sycl {
 namespace detail {
 
-template <typename T, typename = void>
-struct SupportsQueueProfiling {
-  static constexpr bool value = false;
-};
-
-template <typename T>
-struct SupportsQueueProfiling<T,
-    std::void_t<decltype(std::declval<T>().run(std::declval<std::vector<cl::sycl::event>&>()))>> {
-  static constexpr bool value = true;
-};
-
 #define MAKE_HAS_METHOD_TRAIT(T, method, name)                                                                         \
   template <typename _T>                                                                                               \
   static constexpr std::false_type _has_##method(...);                                                                 \
@@ -30,8 +19,8 @@ template <typename T>
 struct BenchmarkTraits {
   MAKE_HAS_METHOD_TRAIT(T, verify, hasVerify)
   MAKE_HAS_METHOD_TRAIT(T, getThroughputMetric, hasGetThroughputMetric)
-
-  static constexpr bool supportsQueueProfiling = SupportsQueueProfiling<T>::value;
+  MAKE_HAS_METHOD_TRAIT(T, getRooflineMetric, hasGetRooflineMetric)
+  MAKE_HAS_METHOD_TRAIT(T, getNumElements, hasGetNumElements)
 };
 
 }}} // namespace
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+/**
+ * Compile-time lists of benchmark instantiations. A benchmark templated over
+ * e.g. data type and iteration count instantiates all combinations in one
+ * binary, and selects the ones to run at runtime (see BenchmarkApp::shouldRunType):
+ *
+ *   forEachVariant(TypeList<int, float>{}, ValueList<8, 16>{}, [&](auto type, auto iters) {
+ *     using T = typename decltype(type)::type;
+ *     constexpr int Iterations = decltype(iters)::value;
+ *     ...
+ *   });
+ */
+template<class T>
+struct TypeTag { using type = T; };
+
+template<class... Ts>
+struct TypeList {};
+
+template<int... Values>
+using ValueList = std::integer_sequence<int, Values...>;
+
+template<class... Ts, class F>
+void forEachType(TypeList<Ts...>, F&& f)
+{
+  (f(TypeTag<Ts>{}), ...);
+}
+
+template<int... Values, class F>
+void forEachValue(ValueList<Values...>, F&& f)
+{
+  (f(std::integral_constant<int, Values>{}), ...);
+}
+
+template<class... Ts, int... Values, class F>
+void forEachVariant(TypeList<Ts...> types, ValueList<Values...>, F&& f)
+{
+  forEachType(types, [&](auto type) {
+    (f(type, std::integral_constant<int, Values>{}), ...);
+  });
+}
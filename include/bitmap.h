@@ -8,8 +8,8 @@
 using std::string;
 
 
-void load_bitmap_mirrored(string filename, int size, std::vector<cl::sycl::float4> &pixels);
-void save_bitmap(string filename, int size, const std::vector<cl::sycl::float4> &buffer);
+inline void load_bitmap_mirrored(string filename, int size, std::vector<cl::sycl::float4> &pixels);
+inline void save_bitmap(string filename, int size, const std::vector<cl::sycl::float4> &buffer);
 
 /**
   A single Pixel in the image. A Pixel has red, green, and blue
@@ -142,7 +142,7 @@ struct bmpfile_dib_info
  *
  * @param name of the filename to be opened and read as a matrix of pixels
 **/
-void Bitmap::open(std::string filename)
+inline void Bitmap::open(std::string filename)
 {
 	std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
         //clear data if already holds information
@@ -244,7 +244,7 @@ void Bitmap::open(std::string filename)
  *
  * @param name of the filename to be written as a bmp image
 **/
-void Bitmap::save(std::string filename)
+inline void Bitmap::save(std::string filename)
 {
 	std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
 
@@ -321,7 +321,7 @@ void Bitmap::save(std::string filename)
   *
   * @return boolean value of whether or not the matrix is a valid image
  **/
-bool Bitmap::isImage()
+inline bool Bitmap::isImage()
 {
 	const int height = pixels.size();
 
@@ -356,7 +356,7 @@ bool Bitmap::isImage()
  *
  * @return the bitmap image, represented by a matrix of RGB pixels
 **/
-PixelMatrix Bitmap::toPixelMatrix()
+inline PixelMatrix Bitmap::toPixelMatrix()
 {
 	if( isImage() )
 	{
@@ -376,7 +376,7 @@ PixelMatrix Bitmap::toPixelMatrix()
  *
  * @param a matrix of pixels to represent a bitmap
 **/
-void Bitmap::fromPixelMatrix(const PixelMatrix & values)
+inline void Bitmap::fromPixelMatrix(const PixelMatrix & values)
 {
 	pixels = values;
 }
@@ -385,7 +385,7 @@ void Bitmap::fromPixelMatrix(const PixelMatrix & values)
 #endif
 
 
-void load_bitmap_mirrored(string filename, int size, std::vector<cl::sycl::float4> &input){
+inline void load_bitmap_mirrored(string filename, int size, std::vector<cl::sycl::float4> &input){
   Bitmap input_image;
   input_image.open(filename);
   //std::cout << "input image " << filename << " loaded" << std::endl;
@@ -409,7 +409,7 @@ void load_bitmap_mirrored(string filename, int size, std::vector<cl::sycl::float
 }
 
 
-void save_bitmap(string filename, int size, const std::vector<cl::sycl::float4> &output){
+inline void save_bitmap(string filename, int size, const std::vector<cl::sycl::float4> &output){
     // write the output picture
     //std::cout << "saving the output picture in " << filename << std::endl;
     Bitmap output_image;
@@ -9,9 +9,20 @@
 #include <iostream>
 #include <sstream>
 #include <memory>
+#include <chrono>
+#include <map>
+#include <cstdint>
+#include <utility>
+#include <mpi.h>
 //#include <CL/sycl.hpp>
 #include <celerity/celerity.h>
 #include "result_consumer.h"
+#include "baseline.h"
+#include "input_file.h"
+// Defines BENCH_GIT_REVISION, generated by the build (see cmake/git_revision.cmake)
+#if __has_include("git_revision.h")
+#include "git_revision.h"
+#endif
 
 using CommandLineArguments = std::unordered_map<std::string, std::string>;
 using FlagList = std::unordered_set<std::string>;
@@ -59,6 +70,63 @@ inline SyclArraylike parseSyclArray(const std::string& s, std::size_t defaultVal
     throw std::invalid_argument{"Invalid sycl range/id: "+s};
 }
 
+// Parses problem size sweeps: "256:16384:x2" (geometric), "1024:4096:+1024" (arithmetic,
+// also "1024:4096:1024"), "1024,2048,3072" (list) or a single size. Bounds are inclusive.
+inline std::vector<std::size_t> parseProblemSizes(const std::string& s)
+{
+  if(s.find(':') == std::string::npos)
+    return parseCommaDelimitedList<std::size_t>(s);
+
+  std::vector<std::string> parts;
+  std::stringstream istr(s);
+  std::string current;
+  while(std::getline(istr, current, ':'))
+    parts.push_back(current);
+  if(parts.size() < 2 || parts.size() > 3)
+    throw std::invalid_argument{"Invalid problem size sweep: "+s};
+
+  const auto first = simple_cast<std::size_t>(parts[0]);
+  const auto last = simple_cast<std::size_t>(parts[1]);
+  const std::string step = parts.size() == 3 ? parts[2] : "x2";
+
+  std::vector<std::size_t> sizes;
+  if(step[0] == 'x') {
+    const auto factor = simple_cast<std::size_t>(step.substr(1));
+    if(factor < 2 || first == 0)
+      throw std::invalid_argument{"Invalid geometric problem size sweep: "+s};
+    for(std::size_t size = first; size <= last; size *= factor)
+      sizes.push_back(size);
+  } else {
+    const auto increment = simple_cast<std::size_t>(step[0] == '+' ? step.substr(1) : step);
+    if(increment == 0)
+      throw std::invalid_argument{"Invalid arithmetic problem size sweep: "+s};
+    for(std::size_t size = first; size <= last; size += increment)
+      sizes.push_back(size);
+  }
+  if(sizes.empty())
+    throw std::invalid_argument{"Empty problem size sweep: "+s};
+  return sizes;
+}
+
+// Parses durations such as "60s", "500ms", "2min" or "1h". A plain number is taken as seconds.
+inline std::chrono::duration<double> parseDuration(const std::string& s)
+{
+  std::size_t unit_pos = 0;
+  const double value = std::stod(s, &unit_pos);
+  const std::string unit = s.substr(unit_pos);
+
+  if(unit.empty() || unit == "s")
+    return std::chrono::duration<double>{value};
+  else if(unit == "ms")
+    return std::chrono::duration<double, std::milli>{value};
+  else if(unit == "min")
+    return std::chrono::duration<double, std::ratio<60>>{value};
+  else if(unit == "h")
+    return std::chrono::duration<double, std::ratio<3600>>{value};
+  else
+    throw std::invalid_argument{"Invalid duration: "+s};
+}
+
 }}}
 
 template<class T>
@@ -81,6 +149,13 @@ cast(const std::string& s)
   return cl::sycl::detail::parseSyclArray<cl::sycl::id<3>>(s, 0);
 }
 
+template<>
+inline std::chrono::duration<double>
+cast(const std::string& s)
+{
+  return cl::sycl::detail::parseDuration(s);
+}
+
 /*
 	std::unique_ptr<runtime> runtime::instance = nullptr;
 
@@ -145,6 +220,13 @@ public:
   static void sync() {
     getInstance().slow_full_sync();
   }
+  // Waits until this node has completed all work submitted so far, without waiting for the other nodes.
+  // Submits an epoch like sync(), so it has to be called by all nodes.
+  static void localSync() {
+    getInstance();
+    auto& task_mngr = celerity::detail::runtime::get_instance().get_task_manager();
+    task_mngr.await_epoch(task_mngr.generate_epoch_task(celerity::detail::epoch_action::none));
+  }
   QueueManager(QueueManager const&)   = delete;
   void operator=(QueueManager const&) = delete;
 private:
@@ -161,6 +243,7 @@ public:
     for (int i = 0; i < argc; ++i)
     {
       std::string arg = argv[i];
+      commandLine += (i == 0 ? "" : " ") + arg;
       auto pos = arg.find("=");
       if(pos != std::string::npos)
       {
@@ -208,6 +291,12 @@ public:
     }
   }
 
+  // The full command line, as given
+  const std::string& getCommandLine() const
+  {
+    return commandLine;
+  }
+
   bool isFlagSet(const std::string& flag) const
   {
     return flags.find(flag) != flags.end();
@@ -220,27 +309,91 @@ private:
 
   CommandLineArguments args;
   FlagList flags;
+  std::string commandLine;
 };
 
 
 struct VerificationSetting
 {
+  // How verifyPartitions() checks a result (--verify=full|sample:N|checksum)
+  enum class Mode { full, sample, checksum };
+
   bool enabled;
   cl::sycl::id<3> begin = {0, 0, 0};
   cl::sycl::range<3> range = {1, 1, 1};
+  Mode mode = Mode::full;
+  // number of pseudo-random points checked in sample mode
+  std::size_t samples = 1024;
+  // selects the sampled points, so all nodes agree on them
+  std::uint64_t seed = 0;
+  // directory of the golden digest cache (--golden-dir), disabled if empty, see golden_cache.h
+  std::string golden_dir;
+  // identifies the benchmark run in the golden cache, set by BenchmarkManager
+  std::string golden_key;
+  // number of buffers verified so far in the current verify(), reset by BenchmarkManager
+  std::size_t golden_index = 0;
+
+  // The --verify argument these settings were parsed from
+  std::string getModeName() const {
+    switch(mode) {
+    case Mode::sample: return "sample:" + std::to_string(samples);
+    case Mode::checksum: return "checksum";
+    default: return "full";
+    }
+  }
+
+  void parseMode(const std::string& arg) {
+    if(arg == "full") {
+      mode = Mode::full;
+    } else if(arg == "checksum") {
+      mode = Mode::checksum;
+    } else if(arg == "sample" || arg.rfind("sample:", 0) == 0) {
+      mode = Mode::sample;
+      if(arg.size() > 7) {
+        samples = std::stoull(arg.substr(7));
+      }
+      if(samples == 0) {
+        throw std::invalid_argument{"Invalid --verify sample count: " + arg};
+      }
+    } else {
+      throw std::invalid_argument{"Invalid --verify mode: " + arg};
+    }
+  }
 };
 
 struct BenchmarkArgs
 {
   size_t problem_size;
+  // all sizes of a --size sweep; BenchmarkApp runs each benchmark once per size
+  std::vector<size_t> problem_sizes;
   size_t local_size;
   size_t num_runs;
+  // untimed runs executed before the measured ones, reported as warmup-time-*
+  size_t warmup_runs;
+  // adaptive repetition: keep running past num_runs until the 95% CI of the
+  // run-time median is within target_rel_ci, or max_runs/max_time is reached (0 disables)
+  double target_rel_ci;
+  size_t max_runs;
+  std::chrono::duration<double> max_time;
   //cl::sycl::queue device_queue;
   //celerity::distr_queue& device_queue;
   VerificationSetting verification;
   // can be used to query additional benchmark specific information from the command line
   CommandLine cli;
   std::shared_ptr<ResultConsumer> result_consumer;
+  // samples of an earlier run to compare against (--baseline), may be null
+  std::shared_ptr<const Baseline> baseline;
+  // seed of the random inputs (--seed), see generators::Random
+  std::uint64_t seed = 42;
+  // datasets replacing the generated inputs of a benchmark, in the order of its inputs (--input-file)
+  std::vector<std::shared_ptr<const InputFile>> input_files;
+  // CPU affinity of every rank, set by BenchmarkApp (see process_placement.h)
+  std::string affinity = "";
+
+  // The i-th --input-file, or null if there is none
+  std::shared_ptr<const InputFile> getInputFile(std::size_t i) const {
+    return i < input_files.size() ? input_files[i] : nullptr;
+  }
 };
 
 class CUDASelector : public cl::sycl::device_selector {
@@ -263,10 +416,16 @@ public:
 
   BenchmarkArgs getBenchmarkArgs() const
   {
-    std::size_t size = cli_parser.getOrDefault<std::size_t>("--size", 3072);
+    auto sizes = cl::sycl::detail::parseProblemSizes(cli_parser.getOrDefault<std::string>("--size", "3072"));
+    std::size_t size = sizes.front();
     std::size_t local_size = cli_parser.getOrDefault<std::size_t>("--local", 256);
     // more than 1 run per process will cause caching in the runtime
     std::size_t num_runs = cli_parser.getOrDefault<std::size_t>("--num-runs", 1);
+    std::size_t warmup_runs = cli_parser.getOrDefault<std::size_t>("--warmup-runs", 0);
+    double target_rel_ci = cli_parser.getOrDefault<double>("--target-rel-ci", 0.0);
+    std::size_t max_runs = cli_parser.getOrDefault<std::size_t>("--max-runs", 200);
+    auto max_time = cli_parser.getOrDefault<std::chrono::duration<double>>(
+      "--max-time", std::chrono::seconds{60});
 
     std::string device_type = cli_parser.getOrDefault<std::string>("--device", "default");
     //cl::sycl::queue q = getQueue(device_type);
@@ -282,18 +441,44 @@ public:
     auto verification_range = cli_parser.getOrDefault<cl::sycl::range<3>>(
       "--verification-range", cl::sycl::range<3>{1,1,1});
 
+    const auto seed = cli_parser.getOrDefault<std::uint64_t>("--seed", 42);
+
+    VerificationSetting verification{verification_enabled, verification_begin, verification_range};
+    verification.parseMode(cli_parser.getOrDefault<std::string>("--verify", "full"));
+    verification.seed = seed;
+    verification.golden_dir = cli_parser.getOrDefault<std::string>("--golden-dir", "");
+
     auto result_consumer = getResultConsumer(
       cli_parser.getOrDefault<std::string>("--output","stdio"));
 
+    std::shared_ptr<const Baseline> baseline;
+    if(cli_parser.isArgSet("--baseline"))
+      baseline = std::make_shared<const Baseline>(cli_parser.get<std::string>("--baseline"));
+
+    std::vector<std::shared_ptr<const InputFile>> input_files;
+    if(cli_parser.isArgSet("--input-file")) {
+      std::stringstream paths(cli_parser.get<std::string>("--input-file"));
+      std::string path;
+      while(std::getline(paths, path, ',')) {
+        input_files.push_back(std::make_shared<const InputFile>(path));
+      }
+    }
+
     return BenchmarkArgs{size,
+                         sizes,
                          local_size,
                          num_runs,
+                         warmup_runs,
+                         target_rel_ci,
+                         max_runs,
+                         max_time,
                          //q,
-                         VerificationSetting{verification_enabled,
-                                             verification_begin,
-                                             verification_range},
+                         verification,
                          cli_parser,
-                         result_consumer};
+                         result_consumer,
+                         baseline,
+                         seed,
+                         input_files};
   }
 
 private:
@@ -301,14 +486,64 @@ private:
 
   getResultConsumer(const std::string& result_consumer_name) const
   {
+    const std::string jsonl_prefix = "jsonl:";
     if(result_consumer_name == "stdio")
       return std::shared_ptr<ResultConsumer>{new OstreamResultConsumer{std::cout}};
+    else if(result_consumer_name.rfind(jsonl_prefix, 0) == 0)
+      return std::shared_ptr<ResultConsumer>{new JsonLinesResultConsumer{
+          result_consumer_name.substr(jsonl_prefix.size()), collectRunMetadata()}};
     else
       // create result consumer that appends to a csv file, interpreting the output name
       // as the target file name
       return std::shared_ptr<ResultConsumer>{new AppendingCsvResultConsumer{result_consumer_name}};
   }
 
+  /**
+   * Describes the run for self-describing result records. Collective, as the
+   * host names of all ranks are gathered. Values are JSON-encoded.
+   */
+  std::vector<std::pair<std::string, std::string>> collectRunMetadata() const
+  {
+    int num_ranks = 0;
+    MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+    char host[MPI_MAX_PROCESSOR_NAME] = {};
+    int host_length = 0;
+    MPI_Get_processor_name(host, &host_length);
+    std::vector<char> all_hosts(static_cast<std::size_t>(num_ranks) * MPI_MAX_PROCESSOR_NAME);
+    MPI_Allgather(host, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, all_hosts.data(), MPI_MAX_PROCESSOR_NAME, MPI_CHAR,
+        MPI_COMM_WORLD);
+
+    std::map<std::string, int> ranks_per_host;
+    for(int i = 0; i < num_ranks; ++i) {
+      ++ranks_per_host[std::string{&all_hosts[static_cast<std::size_t>(i) * MPI_MAX_PROCESSOR_NAME]}];
+    }
+    std::string hosts;
+    int max_ranks_per_node = 0;
+    for(const auto& [name, ranks] : ranks_per_host) {
+      hosts += (hosts.empty() ? "" : ",") + jsonEscape(name);
+      max_ranks_per_node = std::max(max_ranks_per_node, ranks);
+    }
+
+#ifdef BENCH_GIT_REVISION
+    const std::string git_revision = BENCH_GIT_REVISION;
+#else
+    const std::string git_revision = "unknown";
+#endif
+#ifdef BENCH_COMPILE_DEFINITIONS
+    const std::string compile_definitions = BENCH_COMPILE_DEFINITIONS;
+#else
+    const std::string compile_definitions = "";
+#endif
+
+    return {{"nodes", std::to_string(ranks_per_host.size())},
+            {"ranks", std::to_string(num_ranks)},
+            {"ranks-per-node", std::to_string(max_ranks_per_node)},
+            {"hosts", "[" + hosts + "]"},
+            {"git-revision", jsonEscape(git_revision)},
+            {"compile-definitions", jsonEscape(compile_definitions)},
+            {"command-line", jsonEscape(cli_parser.getCommandLine())}};
+  }
+
 /*cl::sycl::queue getQueue(const std::string& device_type) const {
     const auto getQueueProperties = [&]() -> cl::sycl::property_list {
 #if defined(SYCL_BENCH_ENABLE_QUEUE_PROFILING)
@@ -9,9 +9,14 @@
 #include <algorithm> // for std::min
 #include <type_traits>
 #include <unordered_set>
+#include <set>
 #include <optional>
 #include <iomanip>
 #include <limits>
+#include <chrono>
+#include <regex>
+
+#include <mpi.h>
 
 #include "command_line.h"
 #include "result_consumer.h"
@@ -20,8 +25,16 @@
   
 #include "benchmark_hook.h"
 #include "benchmark_traits.h"
+#include "kernel_profiler.h"
 #include "prefetched_buffer.h"
 #include "time_metrics.h"
+#include "perf_counters.h"
+#include "rapl_energy_meas.h"
+#include "trace_recorder.h"
+#include "process_placement.h"
+#include "host_init.h"
+#include "distributed_verification.h"
+#include "host_reference.h"
 
 #ifdef NV_ENERGY_MEAS    
   #include "nv_energy_meas.h"
@@ -41,83 +54,159 @@ public:
   template<typename... Args>
   void run(Args&&... additionalArgs)
   {
-    args.result_consumer->proceedToBenchmark(Benchmark{args, additionalArgs...}.getBenchmarkName());
+    const auto benchmark_name = Benchmark{args, additionalArgs...}.getBenchmarkName();
+    args.result_consumer->proceedToBenchmark(benchmark_name);
+    TraceRecorder& trace = TraceRecorder::getInstance();
+    TraceRecorder::Scope benchmark_trace{benchmark_name, "benchmark"};
+
+    // Results are emitted by the master node only
+    const bool is_master = celerity::detail::runtime::get_instance().is_master_node();
+    if(is_master) {
+      args.result_consumer->consumeResult(
+        "problem-size", std::to_string(args.problem_size));
+      args.result_consumer->consumeResult(
+        "local-size", std::to_string(args.local_size));
+      //args.result_consumer->consumeResult(
+      //  "device-name", args.device_queue.get_device()
+      //                       .template get_info<cl::sycl::info::device::name>());
+      args.result_consumer->consumeResult(
+        "sycl-implementation", this->getSyclImplementation());
+      args.result_consumer->consumeResult(
+        "seed", std::to_string(args.seed));
+      args.result_consumer->consumeResult(
+        "verification-mode", args.verification.getModeName());
+      args.result_consumer->consumeResult(
+        "affinity", args.affinity.empty() ? "N/A" : args.affinity);
+      args.result_consumer->consumeResult(
+        "numa-policy", args.cli.getOrDefault<std::string>("--numa", "default"));
+      std::string input_files;
+      for(const auto& file : args.input_files) {
+        input_files += (input_files.empty() ? "" : " ") + file->getPath();
+      }
+      args.result_consumer->consumeResult(
+        "input-files", input_files.empty() ? "N/A" : input_files);
+    }
 
-    args.result_consumer->consumeResult(
-      "problem-size", std::to_string(args.problem_size));
-    args.result_consumer->consumeResult(
-      "local-size", std::to_string(args.local_size));
-    //args.result_consumer->consumeResult(
-    //  "device-name", args.device_queue.get_device()
-    //                       .template get_info<cl::sycl::info::device::name>());
-    args.result_consumer->consumeResult(
-      "sycl-implementation", this->getSyclImplementation());
+    // Identifies the result in the golden digest cache, together with the data type and range of the buffer
+    args.verification.golden_key = benchmark_name + "/size=" + std::to_string(args.problem_size) +
+                                   "/seed=" + std::to_string(args.seed);
+    for(const auto& file : args.input_files) {
+      args.verification.golden_key += "/input=" + file->getPath();
+    }
 
     TimeMetricsProcessor<Benchmark> time_metrics(args);
 
     for(auto h : hooks) h->atInit();
 
     bool all_runs_pass = true;
-    bool is_master = false;
+    std::size_t completed_runs = 0;
     try {
-      //int world_rank;
-      //MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
-      is_master = celerity::detail::runtime::get_instance().is_master_node();
-      // Run until we have as many runs as requested or until
-      // verification fails
-      for(std::size_t run = 0; run < args.num_runs && all_runs_pass; ++run) {
+      // Warm-up runs absorb JIT compilation, first-touch page faults and runtime
+      // buffer allocation. They are timed separately and skip hooks and verification.
+      for(std::size_t run = 0; run < args.warmup_runs; ++run) {
         Benchmark b(args, additionalArgs...);
 
-        for(auto h : hooks) h->preSetup();
-
-        b.setup();
+        {
+          TraceRecorder::Scope setup_trace{"warmup-setup", benchmark_name};
+          b.setup();
+          QueueManager::sync();
+        }
 
+        const auto before = std::chrono::high_resolution_clock::now();
+        b.run();
+        const auto submitted = std::chrono::high_resolution_clock::now();
         QueueManager::sync();
-        for(auto h : hooks) h->postSetup();
+        const auto after = std::chrono::high_resolution_clock::now();
+        trace.addEvent("warmup-run", benchmark_name, before, submitted);
+        trace.addEvent("warmup-sync", benchmark_name, submitted, after);
+
+        time_metrics.addTimingResult("warmup-time", std::chrono::duration_cast<std::chrono::nanoseconds>(after - before));
+        KernelProfiler::getInstance().takeTimings();
+      }
+      if(args.warmup_runs == 0) {
+        time_metrics.markAsUnavailable("warmup-time");
+      }
+
+      // Run until we have as many runs as requested (or, in adaptive mode, until the
+      // run-time median is tight enough) or until verification fails
+      const auto measure_start = std::chrono::high_resolution_clock::now();
+      for(; all_runs_pass && needsAnotherRun(completed_runs, time_metrics, measure_start); ++completed_runs) {
+        Benchmark b(args, additionalArgs...);
 
-        std::vector<cl::sycl::event> run_events;
-        run_events.reserve(1024); // Make sure we don't need to resize during benchmarking.
+        // setup() may only submit the initialization, so the setup time includes the sync that completes it
+        std::chrono::high_resolution_clock::time_point setup_begin;
+        {
+          TraceRecorder::Scope setup_trace{"setup", benchmark_name};
+          for(auto h : hooks) h->preSetup();
+
+          setup_begin = std::chrono::high_resolution_clock::now();
+          b.setup();
+        }
+
+        {
+          TraceRecorder::Scope sync_trace{"post-setup-sync", benchmark_name};
+          const auto setup_node_end = waitForNode();
+          QueueManager::sync();
+          const auto setup_end = std::chrono::high_resolution_clock::now();
+          time_metrics.addTimingResult(
+            "setup-time", std::chrono::duration_cast<std::chrono::nanoseconds>(setup_end - setup_begin));
+          time_metrics.addNodeTimingResult(
+            "setup-time", std::chrono::duration_cast<std::chrono::nanoseconds>(setup_node_end.value_or(setup_end) - setup_begin));
+          for(auto h : hooks) h->postSetup();
+        }
+
+        // Discard kernels tagged during setup
+        KernelProfiler::getInstance().takeTimings();
 
         // Performance critical measurement section starts here
+        const auto pre_kernel = std::chrono::high_resolution_clock::now();
         for(auto h : hooks) h->preKernel();
         const auto before = std::chrono::high_resolution_clock::now();
-        if constexpr(cl::sycl::detail::BenchmarkTraits<Benchmark>::supportsQueueProfiling) {
-          b.run(run_events);
-        } else {
-          b.run();
-        }
+        b.run();
+        const auto submitted = std::chrono::high_resolution_clock::now();
+        const auto node_done = waitForNode();
         QueueManager::sync();
         const auto after = std::chrono::high_resolution_clock::now();
         for(auto h : hooks) h->postKernel();
         // Performance critical measurement section ends here
 
+        trace.addEvent("pre-kernel", benchmark_name, pre_kernel, before);
+        trace.addEvent("run", benchmark_name, before, submitted);
+        trace.addEvent("sync", benchmark_name, submitted, after);
+
         time_metrics.addTimingResult("run-time", std::chrono::duration_cast<std::chrono::nanoseconds>(after - before));
+        time_metrics.addNodeTimingResult(
+          "run-time", std::chrono::duration_cast<std::chrono::nanoseconds>(node_done.value_or(after) - before));
 
-        if(cl::sycl::detail::BenchmarkTraits<Benchmark>::supportsQueueProfiling) {
-#if defined(SYCL_BENCH_ENABLE_QUEUE_PROFILING)
-          // TODO: We might also want to consider the "command_submit" time.
+        const auto kernel_timings = KernelProfiler::getInstance().takeTimings();
+        if(kernel_timings.empty()) {
+          time_metrics.markAsUnavailable("kernel-time");
+        } else {
           std::chrono::nanoseconds total_time{0};
-          for(auto& e : run_events) {
-            const auto start = e.get_profiling_info<cl::sycl::info::event_profiling::command_start>();
-            const auto end = e.get_profiling_info<cl::sycl::info::event_profiling::command_end>();
-            total_time += std::chrono::nanoseconds(end - start);
+          for(const auto& [tag, time] : kernel_timings) {
+            // Fenced by node-local syncs, so these are this node's own times
+            time_metrics.addTimingResult("kernel-time-" + tag, time);
+            time_metrics.addNodeTimingResult("kernel-time-" + tag, time);
+            total_time += time;
           }
           time_metrics.addTimingResult("kernel-time", total_time);
-#else
-          time_metrics.markAsUnavailable("kernel-time");
-#endif
-        } else {
-          time_metrics.markAsUnavailable("kernel-time");
+          time_metrics.addNodeTimingResult("kernel-time", total_time);
         }
 
         if constexpr(cl::sycl::detail::BenchmarkTraits<Benchmark>::hasVerify) {
           if(args.verification.range.size() > 0) {
             if(args.verification.enabled) {
               std::cerr << "Starting verification\n";
+              TraceRecorder::Scope verify_trace{"verify", benchmark_name};
+              args.verification.golden_index = 0;
               if(!b.verify(args.verification)) {
                 all_runs_pass = false;
               }
               QueueManager::sync();
+              // Some benchmarks verify on the master node only; all nodes have to stop after the same run
+              int pass = all_runs_pass;
+              MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+              all_runs_pass = pass != 0;
             }
           }
         }
@@ -127,8 +216,19 @@ public:
       std::rethrow_exception(std::current_exception());
     }
 
+    // Every node has recorded its own samples; collect them on the master node
+    time_metrics.gatherNodeResults();
+    for(auto h : hooks) h->gatherResults();
+    // Already reduced over all nodes by verifyPartitions()
+    const auto verification_max_error = VerificationErrors::getInstance().takeMaxError();
+    const auto golden_status = GoldenCache::getInstance().takeStatus();
+
     if (is_master) {
       time_metrics.emitResults(*args.result_consumer);
+      args.result_consumer->consumeResult("num-runs", std::to_string(completed_runs));
+      if(args.baseline) {
+        compareToBaseline(benchmark_name, time_metrics);
+      }
 
       for (auto h : hooks) {
         // Extract results from the hooks
@@ -147,15 +247,94 @@ public:
         // pass
         args.result_consumer->consumeResult("Verification", "PASS");
       }
+      args.result_consumer->consumeResult("verification-max-error",
+          verification_max_error ? std::to_string(*verification_max_error) : "N/A");
+      args.result_consumer->consumeResult("verification-golden", golden_status.value_or("N/A"));
     }
     
     args.result_consumer->flush();
     
   }
 
+  // Whether the run-time is significantly slower than in the baseline (master node only)
+  bool hasRegressed() const { return regressed; }
+
 private:
   BenchmarkArgs args;  
   std::vector<BenchmarkHook*> hooks;
+  bool regressed = false;
+
+  /**
+   * Compares the run-time samples with those of the same benchmark and problem size in
+   * the baseline. The speedup is the ratio of the medians (> 1 is faster). A run counts as
+   * regression if the Mann-Whitney U test rejects equal distributions at --significance
+   * (0.05) and the median got slower by more than --regression-threshold (0.05, i.e. 5%).
+   */
+  void compareToBaseline(const std::string& benchmark_name, const TimeMetricsProcessor<Benchmark>& time_metrics)
+  {
+    const auto baseline_samples = args.baseline->getSamples(benchmark_name, args.problem_size, "run-time");
+    if(!baseline_samples || baseline_samples->empty()) {
+      args.result_consumer->consumeResult("baseline-speedup", "N/A");
+      args.result_consumer->consumeResult("baseline-p-value", "N/A");
+      args.result_consumer->consumeResult("baseline-significant", "N/A");
+      args.result_consumer->consumeResult("baseline-regression", "N/A");
+      return;
+    }
+
+    const double significance = args.cli.getOrDefault<double>("--significance", 0.05);
+    const double threshold = args.cli.getOrDefault<double>("--regression-threshold", 0.05);
+
+    const auto samples = time_metrics.getSortedSeconds("run-time");
+    const double baseline_median = TimeMetricsProcessor<Benchmark>::getPercentile(*baseline_samples, 50.0);
+    const double median = TimeMetricsProcessor<Benchmark>::getPercentile(samples, 50.0);
+    const double speedup = median > 0.0 ? baseline_median / median : 0.0;
+    const double p_value = Baseline::mannWhitneyPValue(*baseline_samples, samples);
+    const bool significant = p_value < significance;
+    regressed = significant && speedup > 0.0 && 1.0 / speedup > 1.0 + threshold;
+
+    args.result_consumer->consumeResult("baseline-speedup", std::to_string(speedup));
+    args.result_consumer->consumeResult("baseline-p-value", std::to_string(p_value));
+    args.result_consumer->consumeResult("baseline-significant", significant ? "yes" : "no");
+    args.result_consumer->consumeResult("baseline-regression", regressed ? "yes" : "no");
+    if(regressed) {
+      std::cerr << "Regression: " << benchmark_name << " (size " << args.problem_size << ") is "
+                << (1.0 / speedup - 1.0) * 100.0 << "% slower than the baseline (p = " << p_value << ")" << std::endl;
+    }
+  }
+
+  /**
+   * With several nodes, waits until this node has completed its own work and returns the time,
+   * so that the per-node timings are not leveled by the barrier of the following sync.
+   * On a single node the sync itself is local and nothing is waited for.
+   */
+  static std::optional<std::chrono::high_resolution_clock::time_point> waitForNode()
+  {
+    int num_nodes = 1;
+    MPI_Comm_size(MPI_COMM_WORLD, &num_nodes);
+    if(num_nodes == 1) return std::nullopt;
+    QueueManager::localSync();
+    return std::chrono::high_resolution_clock::now();
+  }
+
+  // The decision is taken on the master node and broadcast, as all nodes
+  // have to submit the same number of runs.
+  bool needsAnotherRun(std::size_t completed_runs, const TimeMetricsProcessor<Benchmark>& time_metrics,
+      std::chrono::high_resolution_clock::time_point start) const
+  {
+    if(completed_runs < args.num_runs) return true;
+    if(args.target_rel_ci <= 0.0) return false;
+
+    int again = 0;
+    if(celerity::detail::runtime::get_instance().is_master_node()) {
+      const auto rel_ci = time_metrics.getRelativeMedianCI("run-time");
+      const bool converged = rel_ci.has_value() && *rel_ci <= args.target_rel_ci;
+      const bool budget_left = completed_runs < args.max_runs &&
+                               std::chrono::high_resolution_clock::now() - start < args.max_time;
+      again = !converged && budget_left;
+    }
+    MPI_Bcast(&again, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    return again != 0;
+  }
 
   std::string getSyclImplementation() const {
 #if defined(__HIPSYCL__)
@@ -178,22 +357,59 @@ private:
 class BenchmarkApp
 {
   BenchmarkArgs args;  
-  std::unordered_set<std::string> benchmark_names;
+  // (name, problem size) of the benchmarks run so far
+  std::set<std::pair<std::string, std::size_t>> benchmark_names;
+  std::size_t num_regressions = 0;
+  // --benchmark=<regex> restricts which benchmarks are run (or listed)
+  std::optional<std::regex> benchmark_filter;
   
 public:  
   BenchmarkApp(int argc, char** argv)
   {
+#ifdef __linux__
+    // The runtime's threads inherit the affinity and memory policy of the main thread. Invalid
+    // modes are not caught below, so that the process exits instead of running unpinned.
+    if(!celerity::detail::runtime::is_initialized()) {
+      const CommandLine placement_cli{argc, argv};
+      ProcessPlacement::applyPinning(placement_cli.getOrDefault<std::string>("--pin", "none"));
+      if(placement_cli.isArgSet("--numa")) {
+        ProcessPlacement::applyNumaPolicy(placement_cli.get<std::string>("--numa"));
+      }
+    }
+#endif
     try{
       if (!celerity::detail::runtime::is_initialized()) {
         celerity::runtime::init(&argc, &argv);
       }
       args = BenchmarkCommandLine{argc, argv}.getBenchmarkArgs();
+#ifdef __linux__
+      args.affinity = gatherAffinity();
+#endif
+      if(args.cli.isArgSet("--benchmark")) {
+        benchmark_filter = std::regex{args.cli.get<std::string>("--benchmark")};
+      }
+      if(args.cli.isArgSet("--trace")) {
+        TraceRecorder::getInstance().enable();
+      }
+      KernelProfiler::getInstance().setEnabled(args.cli.isFlagSet("--kernel-profiling"));
     }
     catch(std::exception& e){
       std::cerr << "Error while parsing command lines: " << e.what() << std::endl;
     }
   }
 
+  // Writing the trace is collective, so all nodes have to destroy their app
+  ~BenchmarkApp()
+  {
+    if(args.cli.isArgSet("--trace")) {
+      TraceRecorder::getInstance().write(args.cli.get<std::string>("--trace"));
+    }
+  }
+
+  // Nonzero if any benchmark regressed against the --baseline
+  int getExitCode() const
+  { return num_regressions > 0 ? 1 : 0; }
+
   const BenchmarkArgs& getArgs() const
   { return args; }
 
@@ -202,26 +418,111 @@ public:
     return !args.cli.isFlagSet("--no-ndrange-kernels");
   }
 
+  // --types=int,float,fp64,... selects data types by C++ or readable name; all by default
+  template<class T>
+  bool shouldRunType() const
+  {
+    if(!args.cli.isArgSet("--types")) return true;
+    const auto types = cl::sycl::detail::parseCommaDelimitedList<std::string>(args.cli.get<std::string>("--types"));
+    return std::any_of(types.begin(), types.end(), [](const std::string& t) {
+      return t == ReadableTypename<T>::name || t == ReadableTypename<T>::cpp_name;
+    });
+  }
+
+  // --iters=8..1024 (inclusive range) or --iters=8,16,32
+  bool shouldRunIterations(int iterations) const
+  {
+    return isValueSelected("--iters", iterations);
+  }
+
+  // --dims=1..2 or --dims=1,3
+  bool shouldRunDims(int dims) const
+  {
+    return isValueSelected("--dims", dims);
+  }
+
+  // --variant=naive,tiled selects kernel variants by name; all by default
+  bool shouldRunVariant(const std::string& variant) const
+  {
+    if(!args.cli.isArgSet("--variant")) return true;
+    const auto variants = cl::sycl::detail::parseCommaDelimitedList<std::string>(args.cli.get<std::string>("--variant"));
+    return std::find(variants.begin(), variants.end(), variant) != variants.end();
+  }
+
+  // Whether --variant names variant explicitly, rather than selecting all variants by default
+  bool isVariantRequested(const std::string& variant) const
+  {
+    return args.cli.isArgSet("--variant") && shouldRunVariant(variant);
+  }
+
+  // --tile=8..16 or --tile=8,32
+  bool shouldRunTileSize(int tile_size) const
+  {
+    return isValueSelected("--tile", tile_size);
+  }
+
+  // Runs the benchmark once for every problem size of the --size sweep
   template<class Benchmark, typename... AdditionalArgs>
   void run(AdditionalArgs&&... additional_args)
+  {
+    for(const auto size : args.problem_sizes) {
+      BenchmarkArgs size_args = args;
+      size_args.problem_size = size;
+      runWithArgs<Benchmark>(size_args, additional_args...);
+    }
+  }
+
+private:
+  template<class Benchmark, typename... AdditionalArgs>
+  void runWithArgs(const BenchmarkArgs& run_args, AdditionalArgs&&... additional_args)
   {
     try {
-      const auto name = Benchmark{args, additional_args...}.getBenchmarkName();
-      if(benchmark_names.count(name) == 0) {
-        benchmark_names.insert(name);
+      const auto name = Benchmark{run_args, additional_args...}.getBenchmarkName();
+      if(benchmark_filter && !std::regex_search(name, *benchmark_filter)) {
+        return;
+      }
+      if(benchmark_names.count({name, run_args.problem_size}) == 0) {
+        benchmark_names.insert({name, run_args.problem_size});
       } else {
-        std::cerr << "Benchmark with name '" << name << "' has already been run\n";
+        std::cerr << "Benchmark with name '" << name << "' has already been run for size "
+                  << run_args.problem_size << "\n";
         throw std::runtime_error("Duplicate benchmark name");
       }
 
-      BenchmarkManager<Benchmark> mgr(args);
+      if(run_args.cli.isFlagSet("--list")) {
+        // list each benchmark only once, not for every size of the sweep
+        if(celerity::detail::runtime::get_instance().is_master_node() &&
+            run_args.problem_size == run_args.problem_sizes.front()) {
+          std::cout << name << std::endl;
+        }
+        return;
+      }
+
+      BenchmarkManager<Benchmark> mgr(run_args);
 
 #ifdef NV_ENERGY_MEAS
       NVEnergyMeasurement nvem;
       mgr.addHook(nvem);
 #endif
 
+#ifdef __linux__
+      std::optional<PerfCounterMeasurement<Benchmark>> perf_counters;
+      if(run_args.cli.isFlagSet("--perf-counters")) {
+        perf_counters.emplace(run_args);
+        mgr.addHook(*perf_counters);
+      }
+#endif
+
+      std::optional<RaplEnergyMeasurement<Benchmark>> rapl_energy;
+      if(run_args.cli.isFlagSet("--rapl-energy")) {
+        rapl_energy.emplace(run_args);
+        mgr.addHook(*rapl_energy);
+      }
+
       mgr.run(additional_args...);
+      if(mgr.hasRegressed()) {
+        ++num_regressions;
+      }
     }
     catch(cl::sycl::exception& e){
       std::cerr << "SYCL error: " << e.what() << std::endl;
@@ -230,9 +531,49 @@ public:
       std::cerr << "Error: " << e.what() << std::endl;
     }
   }
+#ifdef __linux__
+  // Space-separated CPU lists of all ranks, ordered by rank (complete on the master node only)
+  static std::string gatherAffinity()
+  {
+    constexpr int max_length = 256;
+    char local[max_length] = {};
+    const auto affinity = ProcessPlacement::getAffinity();
+    affinity.copy(local, max_length - 1);
+
+    int rank = 0, num_ranks = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+    std::vector<char> all(rank == 0 ? static_cast<std::size_t>(num_ranks) * max_length : 0);
+    MPI_Gather(local, max_length, MPI_CHAR, all.data(), max_length, MPI_CHAR, 0, MPI_COMM_WORLD);
+
+    std::string result = "\"";
+    for(int i = 0; rank == 0 && i < num_ranks; ++i) {
+      result += (i == 0 ? "" : " ") + std::string{&all[static_cast<std::size_t>(i) * max_length]};
+    }
+    return result + "\"";
+  }
+#endif
+
+  bool isValueSelected(const std::string& arg, int value) const
+  {
+    if(!args.cli.isArgSet(arg)) return true;
+    const auto selection = args.cli.get<std::string>(arg);
+    const auto range_pos = selection.find("..");
+    if(range_pos != std::string::npos) {
+      const auto lo = cast<int>(selection.substr(0, range_pos));
+      const auto hi = cast<int>(selection.substr(range_pos + 2));
+      return value >= lo && value <= hi;
+    }
+    const auto values = cl::sycl::detail::parseCommaDelimitedList<int>(selection);
+    return std::find(values.begin(), values.end(), value) != values.end();
+  }
 };
 
 
+#include "benchmark_registry.h"
+#include "benchmark_variants.h"
+
+
 template<class T>
 typename std::enable_if<!std::numeric_limits<T>::is_integer, bool>::type
 almost_equal(T x, T y, int units_last_place)
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <celerity/celerity.h>
+
+#include "philox.h"
+
+/**
+ * Distributed input generators.
+ *
+ * Instead of staging inputs in a host vector that has to be copied from the
+ * master node, a buffer is filled by a generator kernel that writes it with
+ * no_init and a one_to_one range mapper, so each node only generates its own
+ * partition: see PrefetchedBuffer::initialize(range, generator).
+ *
+ * A generator is a trivially copyable functor mapping the 2D index (i, j) of an
+ * element to its value; 1D buffers pass j = 0, 3D buffers are viewed as 2D with
+ * rows (i * range[1] + j) and columns k. The same functor can be called on
+ * the host, e.g. makeHostMatrix<T>(rows, cols, generator) to build the input of
+ * a reference computation.
+ */
+namespace generators {
+
+// 1 on the diagonal, 0 elsewhere
+template <typename T>
+struct Identity {
+  T operator()(std::size_t i, std::size_t j) const { return static_cast<T>(i == j); }
+};
+
+// The same value everywhere
+template <typename T>
+struct Constant {
+  T value = T{};
+
+  T operator()(std::size_t, std::size_t) const { return value; }
+};
+
+// start + the row-major linear index of the element in a buffer with the given number of columns
+template <typename T>
+struct Iota {
+  std::size_t cols = 1;
+  T start = T{};
+
+  T operator()(std::size_t i, std::size_t j) const { return start + static_cast<T>(i * cols + j); }
+};
+
+// The polybench initialization pattern ((i + i_offset) * (j + j_offset) + c) / n, evaluated in T
+template <typename T>
+struct Affine {
+  T i_offset = 0;
+  T j_offset = 0;
+  T c = 0;
+  T n = 1;
+
+  T operator()(std::size_t i, std::size_t j) const {
+    return ((static_cast<T>(i) + i_offset) * (static_cast<T>(j) + j_offset) + c) / n;
+  }
+};
+
+// Uniformly distributed values between min and max, drawn from Philox4x32 with counter (i, j):
+// identical on any number of nodes and on the host
+template <typename T>
+struct Random {
+  std::uint64_t seed = 0;
+  T min = 0;
+  T max = 1;
+
+  T operator()(std::size_t i, std::size_t j) const {
+    const auto bits = Philox4x32::generate(seed, i, j);
+    if constexpr(std::is_same_v<T, float>) {
+      return min + (max - min) * Philox4x32::toUniformFloat(bits[0]);
+    } else {
+      return min + static_cast<T>(static_cast<double>(max - min) * Philox4x32::toUniformDouble(bits[0], bits[1]));
+    }
+  }
+};
+
+} // namespace generators
+
+template <typename T, int Dims, typename Generator>
+class GenerateKernel;
+
+// Fills buf with gen on the nodes owning the respective partitions
+template <typename T, int Dims, typename Generator>
+void generate(celerity::distr_queue& queue, celerity::buffer<T, Dims> buf, Generator gen) {
+  queue.submit([=](celerity::handler& cgh) {
+    celerity::accessor out{buf, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
+    const auto range = buf.get_range();
+    cgh.parallel_for<GenerateKernel<T, Dims, Generator>>(range, [=](celerity::item<Dims> item) {
+      if constexpr(Dims == 1) {
+        out[item] = gen(item[0], 0);
+      } else if constexpr(Dims == 2) {
+        out[item] = gen(item[0], item[1]);
+      } else {
+        out[item] = gen(item[0] * range[1] + item[1], item[2]);
+      }
+    });
+  });
+}
@@ -0,0 +1,405 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <celerity/celerity.h>
+#include <mpi.h>
+
+#include "command_line.h"
+#include "golden_cache.h"
+#include "philox.h"
+#include "type_traits.h"
+
+/**
+ * Partition-local verification of benchmark results.
+ *
+ * Instead of gathering the whole result on the master node, each node checks
+ * the partition it is assigned in a host task over the buffer range, reading
+ * its own sub-range with a one_to_one range mapper and comparing it against a
+ * reference computed for that sub-range only. The per-node results are then
+ * combined with an MPI reduction, so every node returns the same result.
+ *
+ * The reference is a functor mapping the element index (i, j) to the expected
+ * value, with the same conventions as the generators in device_generators.h:
+ * 1D buffers pass j = 0, 3D buffers are viewed as 2D with rows
+ * (i * range[1] + j) and columns k. A block reference instead computes all
+ * expected values of a block of that 2D view at once,
+ *   ref(row_begin, row_end, col_begin, col_end, T* out)
+ * writing them row-major to out, e.g. with the kernels of host_reference.h.
+ * Results can be restricted to a region of the buffer, e.g. the inner points
+ * written by a stencil.
+ *
+ * How much is checked depends on VerificationSetting::mode (--verify):
+ *  - full compares every element with the reference.
+ *  - sample:N compares N pseudo-random elements, drawn from Philox4x32 with
+ *    the seed of the run; only these points of the reference are evaluated.
+ *  - checksum compares an order-independent checksum of the result with the
+ *    checksum of the reference, see VerificationChecksum.
+ *
+ * With --golden-dir, a result that has passed is stored as a digest (see
+ * golden_cache.h) and later runs compare against the digest instead of the
+ * reference. Only results verified in full mode or by an exact checksum are
+ * stored, since a sample or a tolerant checksum does not prove the whole
+ * result correct.
+ */
+struct VerificationResult {
+  bool pass = true;
+  // Largest absolute difference to the reference, infinite if a NaN was found
+  double max_error = 0;
+  std::size_t mismatches = 0;
+
+  operator bool() const { return pass; }
+};
+
+// Accepted difference to a reference value: absolute + relative * |reference|
+struct VerificationTolerance {
+  double absolute = 0;
+  double relative = 0;
+
+  VerificationTolerance(double absolute = 0, double relative = 0) : absolute(absolute), relative(relative) {}
+
+  bool isExact() const { return absolute == 0 && relative == 0; }
+  bool accepts(double error, double reference) const { return error <= absolute + relative * std::abs(reference); }
+};
+
+// Largest error of all verifications since the last call to takeMaxError()
+class VerificationErrors
+{
+public:
+  static VerificationErrors& getInstance() {
+    static VerificationErrors instance;
+    return instance;
+  }
+
+  void record(double error) { max_error = std::max(max_error.value_or(0), error); }
+
+  std::optional<double> takeMaxError() {
+    auto result = max_error;
+    max_error.reset();
+    return result;
+  }
+
+private:
+  std::optional<double> max_error;
+};
+
+/**
+ * Order-independent checksum of a buffer: the wrapping sum of a hash of every
+ * element's bits and linear index, which is exact for any partitioning, plus
+ * the sums of all values and their magnitudes, which are compared within a
+ * tolerance for results that are not bit-exact.
+ */
+struct VerificationChecksum {
+  unsigned long long hash = 0;
+  double sum = 0;
+  double abs_sum = 0;
+
+  template <typename T>
+  void add(T value, std::uint64_t linear_index) {
+    // Adding zero turns -0.0 into 0.0 so both hash the same
+    const T normalized = value + T{0};
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &normalized, std::min(sizeof(T), sizeof(bits)));
+    hash += mix(bits ^ mix(linear_index));
+    sum += static_cast<double>(value);
+    abs_sum += std::abs(static_cast<double>(value));
+  }
+
+  void add(const VerificationChecksum& other) {
+    hash += other.hash;
+    sum += other.sum;
+    abs_sum += other.abs_sum;
+  }
+
+  // Sums the checksums of all nodes
+  VerificationChecksum allreduce() const {
+    VerificationChecksum result;
+    MPI_Allreduce(&hash, &result.hash, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&sum, &result.sum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&abs_sum, &result.abs_sum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    return result;
+  }
+
+  // Bit-exact without a tolerance, otherwise the sums may differ by the tolerance of every element
+  bool matches(const VerificationChecksum& other, const VerificationTolerance& tolerance, std::size_t elements) const {
+    if(tolerance.isExact()) return hash == other.hash;
+    return std::abs(sum - other.sum) <=
+           tolerance.absolute * static_cast<double>(elements) + tolerance.relative * std::max(abs_sum, other.abs_sum);
+  }
+
+private:
+  // splitmix64 finalizer
+  static std::uint64_t mix(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+};
+
+// Verifies the elements of buf inside region against ref
+template <typename T, int Dims, typename Reference>
+VerificationResult verifyPartitions(celerity::distr_queue& queue, celerity::buffer<T, Dims> buf,
+    VerificationSetting& ver, celerity::subrange<Dims> region, Reference ref, VerificationTolerance tolerance = {}) {
+  constexpr bool is_block_reference =
+      std::is_invocable_v<Reference&, std::size_t, std::size_t, std::size_t, std::size_t, T*>;
+  const auto range = buf.get_range();
+  const auto mode = ver.mode;
+  const std::size_t samples = ver.samples;
+  const std::uint64_t seed = ver.seed;
+  std::size_t region_size = 1;
+  for(int d = 0; d < Dims; ++d) region_size *= region.range[d];
+
+  // Nothing to compare (e.g. the inner points of a tiny stencil), and nothing to draw samples from
+  if(region_size == 0) {
+    if(!ver.golden_dir.empty()) ++ver.golden_index;
+    return {};
+  }
+
+  // With a golden cache, the master node looks up the digest of this result and tells the others
+  // whether to skip the reference; they may not see the same cache directory
+  const bool use_golden = !ver.golden_dir.empty();
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  std::string golden_key;
+  std::optional<GoldenCache::Digest> golden;
+  int golden_hit = 0;
+  if(use_golden) {
+    // Buffers verified by the same run are told apart by their order
+    golden_key = ver.golden_key + "/" + std::to_string(ver.golden_index++) + "/" + ReadableTypename<T>::name + "/range=";
+    for(int d = 0; d < Dims; ++d) golden_key += (d == 0 ? "" : "x") + std::to_string(range[d]);
+    if(rank == 0) golden = GoldenCache::getInstance().lookup(ver.golden_dir, golden_key);
+    golden_hit = golden.has_value();
+    MPI_Bcast(&golden_hit, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  }
+  const bool check_reference = !golden_hit;
+  const bool sum_result = (check_reference && mode == VerificationSetting::Mode::checksum) || use_golden;
+
+  struct NodeState {
+    std::mutex mutex;
+    double max_error = 0;
+    unsigned long long mismatches = 0;
+    VerificationChecksum result_checksum;
+    VerificationChecksum reference_checksum;
+    std::vector<double> digest_samples;
+  };
+  // Shared with the host task, which may run on a worker thread for each local chunk
+  const auto state = std::make_shared<NodeState>();
+  state->digest_samples.resize(use_golden ? GoldenCache::num_samples : 0);
+
+  queue.submit([=](celerity::handler& cgh) {
+    celerity::accessor result{buf, cgh, celerity::access::one_to_one{}, celerity::read_only_host_task};
+    cgh.host_task(range, [=](celerity::partition<Dims> part) {
+      // The part of the region inside this partition
+      const auto sr = part.get_subrange();
+      celerity::subrange<Dims> box;
+      bool box_empty = false;
+      for(int d = 0; d < Dims; ++d) {
+        const std::size_t begin = std::max(sr.offset[d], region.offset[d]);
+        const std::size_t end = std::min(sr.offset[d] + sr.range[d], region.offset[d] + region.range[d]);
+        box.offset[d] = begin;
+        box.range[d] = end > begin ? end - begin : 0;
+        box_empty = box_empty || end <= begin;
+      }
+
+      double max_error = 0;
+      unsigned long long mismatches = 0;
+      VerificationChecksum result_checksum, reference_checksum;
+      std::vector<double> digest_samples(state->digest_samples.size());
+
+      // Row and column of an element in the 2D view of the buffer passed to ref
+      const auto toRowCol = [&](celerity::id<Dims> idx) {
+        return std::pair<std::size_t, std::size_t>{
+            Dims == 3 ? idx[0] * range[1] + idx[1] : idx[0], Dims == 1 ? 0 : idx[Dims - 1]};
+      };
+      const auto getLinearIndex = [&](celerity::id<Dims> idx) {
+        const auto [i, j] = toRowCol(idx);
+        return static_cast<std::uint64_t>(i * (Dims == 1 ? 1 : range[Dims - 1]) + j);
+      };
+      // The element of the region at a pseudo-random position drawn by every node alike from
+      // (seed, s, stream), if it lies inside this partition
+      const auto drawInside = [&](std::size_t s, std::uint64_t stream) -> std::optional<celerity::id<Dims>> {
+        const auto bits = Philox4x32::generate(seed, s, stream);
+        std::uint64_t linear = (static_cast<std::uint64_t>(bits[0]) << 32 | bits[1]) % region_size;
+        celerity::id<Dims> idx;
+        bool inside = true;
+        for(int d = Dims - 1; d >= 0; --d) {
+          idx[d] = region.offset[d] + linear % region.range[d];
+          linear /= region.range[d];
+          inside = inside && idx[d] >= box.offset[d] && idx[d] < box.offset[d] + box.range[d];
+        }
+        if(!inside) return std::nullopt;
+        return idx;
+      };
+
+      const bool compare_all = check_reference && mode != VerificationSetting::Mode::sample;
+      // A block reference computes the expected values of the whole box up front, in the order of visit()
+      std::vector<T> expected_block;
+      if constexpr(is_block_reference) {
+        if(compare_all && !box_empty) {
+          std::size_t box_size = 1;
+          for(int d = 0; d < Dims; ++d) box_size *= box.range[d];
+          expected_block.resize(box_size);
+          if constexpr(Dims == 1) {
+            ref(box.offset[0], box.offset[0] + box.range[0], 0, 1, expected_block.data());
+          } else if constexpr(Dims == 2) {
+            ref(box.offset[0], box.offset[0] + box.range[0], box.offset[1], box.offset[1] + box.range[1],
+                expected_block.data());
+          } else {
+            for(std::size_t i = 0; i < box.range[0]; ++i) {
+              const std::size_t row = (box.offset[0] + i) * range[1] + box.offset[1];
+              ref(row, row + box.range[1], box.offset[2], box.offset[2] + box.range[2],
+                  expected_block.data() + i * box.range[1] * box.range[2]);
+            }
+          }
+        }
+      }
+      const auto getExpected = [&](celerity::id<Dims> idx, std::size_t box_index) {
+        const auto [i, j] = toRowCol(idx);
+        if constexpr(is_block_reference) {
+          if(!expected_block.empty()) return expected_block[box_index];
+          T expected;
+          ref(i, i + 1, j, j + 1, &expected);
+          return expected;
+        } else {
+          return static_cast<T>(ref(i, j));
+        }
+      };
+
+      const auto compare = [&](celerity::id<Dims> idx, std::size_t box_index, T value) {
+        const T expected = getExpected(idx, box_index);
+        if(mode == VerificationSetting::Mode::checksum) {
+          reference_checksum.add(expected, getLinearIndex(idx));
+          return;
+        }
+        const double error = std::abs(static_cast<double>(value) - static_cast<double>(expected));
+        if(!tolerance.accepts(error, static_cast<double>(expected))) ++mismatches;
+        max_error = std::isnan(error) ? std::numeric_limits<double>::infinity() : std::max(max_error, error);
+      };
+      std::size_t box_index = 0;
+      const auto visit = [&](celerity::id<Dims> idx) {
+        const T value = result[idx];
+        if(sum_result) result_checksum.add(value, getLinearIndex(idx));
+        if(compare_all) compare(idx, box_index, value);
+        ++box_index;
+      };
+
+      if(check_reference && mode == VerificationSetting::Mode::sample) {
+        // Every node draws the same points and checks those inside its partition
+        for(std::size_t s = 0; s < samples; ++s) {
+          if(const auto idx = drawInside(s, 1)) compare(*idx, 0, result[*idx]);
+        }
+      }
+      for(std::size_t s = 0; s < digest_samples.size(); ++s) {
+        if(const auto idx = drawInside(s, 2)) digest_samples[s] = static_cast<double>(result[*idx]);
+      }
+
+      if(box_empty || (!sum_result && !compare_all)) {
+        // Nothing to do for the elements of the box
+      } else if constexpr(Dims == 1) {
+        for(std::size_t i = box.offset[0]; i < box.offset[0] + box.range[0]; ++i) {
+          visit(celerity::id<1>{i});
+        }
+      } else if constexpr(Dims == 2) {
+        for(std::size_t i = box.offset[0]; i < box.offset[0] + box.range[0]; ++i) {
+          for(std::size_t j = box.offset[1]; j < box.offset[1] + box.range[1]; ++j) {
+            visit(celerity::id<2>{i, j});
+          }
+        }
+      } else {
+        for(std::size_t i = box.offset[0]; i < box.offset[0] + box.range[0]; ++i) {
+          for(std::size_t j = box.offset[1]; j < box.offset[1] + box.range[1]; ++j) {
+            for(std::size_t k = box.offset[2]; k < box.offset[2] + box.range[2]; ++k) {
+              visit(celerity::id<3>{i, j, k});
+            }
+          }
+        }
+      }
+
+      std::lock_guard<std::mutex> lock{state->mutex};
+      state->max_error = std::max(state->max_error, max_error);
+      state->mismatches += mismatches;
+      state->result_checksum.add(result_checksum);
+      state->reference_checksum.add(reference_checksum);
+      // Each point lies in exactly one partition, all others contribute 0
+      for(std::size_t s = 0; s < digest_samples.size(); ++s) state->digest_samples[s] += digest_samples[s];
+    });
+  });
+  queue.slow_full_sync();
+
+  VerificationChecksum result_checksum;
+  std::vector<double> digest_samples(state->digest_samples.size());
+  if(sum_result) result_checksum = state->result_checksum.allreduce();
+  if(use_golden) {
+    MPI_Allreduce(state->digest_samples.data(), digest_samples.data(), static_cast<int>(digest_samples.size()),
+        MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  }
+
+  VerificationResult verification;
+  if(golden_hit) {
+    // Compared on the master node, which holds the digest
+    double result[2] = {0, 0};
+    if(rank == 0) {
+      bool pass =
+          result_checksum.matches(VerificationChecksum{golden->hash, golden->sum}, tolerance, region_size) &&
+          golden->samples.size() == digest_samples.size();
+      double max_error = 0;
+      for(std::size_t s = 0; pass && s < digest_samples.size(); ++s) {
+        const double error = std::abs(digest_samples[s] - golden->samples[s]);
+        if(!tolerance.accepts(error, golden->samples[s])) pass = false;
+        max_error = std::isnan(error) ? std::numeric_limits<double>::infinity() : std::max(max_error, error);
+      }
+      result[0] = pass;
+      result[1] = max_error;
+    }
+    MPI_Bcast(result, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    verification = {result[0] != 0, result[1], result[0] != 0 ? 0u : 1u};
+  } else if(mode == VerificationSetting::Mode::checksum) {
+    const bool pass = result_checksum.matches(state->reference_checksum.allreduce(), tolerance, region_size);
+    verification = {pass, 0, pass ? 0u : 1u};
+  } else {
+    double max_error = 0;
+    unsigned long long mismatches = 0;
+    MPI_Allreduce(&state->max_error, &max_error, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(&state->mismatches, &mismatches, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    verification = {mismatches == 0, max_error, static_cast<std::size_t>(mismatches)};
+  }
+  if(golden_hit || mode != VerificationSetting::Mode::checksum) {
+    VerificationErrors::getInstance().record(verification.max_error);
+  }
+
+  if(use_golden) {
+    if(golden_hit) {
+      GoldenCache::getInstance().setStatus("hit");
+    } else if(!verification.pass) {
+      GoldenCache::getInstance().setStatus("miss");
+    } else if(mode == VerificationSetting::Mode::full ||
+              (mode == VerificationSetting::Mode::checksum && tolerance.isExact())) {
+      // Only results that were checked completely against the reference become golden
+      const bool stored = GoldenCache::getInstance().store(ver.golden_dir, golden_key,
+          GoldenCache::Digest{result_checksum.hash, result_checksum.sum, digest_samples}, rank == 0);
+      GoldenCache::getInstance().setStatus(stored ? "stored" : "not-stored");
+    } else {
+      GoldenCache::getInstance().setStatus("not-stored");
+    }
+  }
+  return verification;
+}
+
+// Verifies all elements of buf against ref
+template <typename T, int Dims, typename Reference>
+VerificationResult verifyPartitions(celerity::distr_queue& queue, celerity::buffer<T, Dims> buf,
+    VerificationSetting& ver, Reference ref, VerificationTolerance tolerance = {}) {
+  return verifyPartitions(queue, buf, ver, celerity::subrange<Dims>{{}, buf.get_range()}, ref, tolerance);
+}
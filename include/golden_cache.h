@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * On-disk cache of verified results (--golden-dir).
+ *
+ * The first verified run of a benchmark stores a compact digest of its result:
+ * the checksum of all elements plus the values at a fixed set of pseudo-random
+ * points. Later runs with the same key (benchmark name, problem size, data
+ * type, buffer range, seed and input files) compare their result against the
+ * digest and skip the reference computation.
+ *
+ * All digests live in a single append-only file <golden-dir>/digests.bin,
+ * which is memory-mapped and parsed once per process on first use. Records
+ * are appended by the master node with a single write each. Only the master
+ * node reads or writes the file, so failures to do so are reported as warnings
+ * and the cache is treated as empty, rather than leaving the other nodes
+ * waiting in the collectives of the verification:
+ *
+ *   u32 key length, key, u64 hash, f64 sum, u32 sample count, f64 samples[]
+ */
+class GoldenCache
+{
+public:
+  struct Digest {
+    unsigned long long hash = 0;
+    double sum = 0;
+    std::vector<double> samples;
+  };
+
+  // Number of sampled points in a digest
+  static constexpr std::size_t num_samples = 64;
+
+  static GoldenCache& getInstance() {
+    static GoldenCache instance;
+    return instance;
+  }
+
+  std::optional<Digest> lookup(const std::string& dir, const std::string& key) {
+    std::lock_guard<std::mutex> lock{mutex};
+    load(dir);
+    const auto it = digests.find(key);
+    if(it == digests.end()) return std::nullopt;
+    return it->second;
+  }
+
+  // Adds a digest; only the writing node (the master) appends it to the file. False if writing failed.
+  bool store(const std::string& dir, const std::string& key, const Digest& digest, bool write) {
+    std::lock_guard<std::mutex> lock{mutex};
+    load(dir);
+    digests[key] = digest;
+    if(!write) return true;
+
+    std::string record;
+    const auto append = [&](const void* data, std::size_t size) { record.append(static_cast<const char*>(data), size); };
+    const auto key_length = static_cast<std::uint32_t>(key.size());
+    const auto sample_count = static_cast<std::uint32_t>(digest.samples.size());
+    append(&key_length, sizeof(key_length));
+    append(key.data(), key.size());
+    append(&digest.hash, sizeof(digest.hash));
+    append(&digest.sum, sizeof(digest.sum));
+    append(&sample_count, sizeof(sample_count));
+    append(digest.samples.data(), digest.samples.size() * sizeof(double));
+
+    mkdir(dir.c_str(), 0755);
+    const int fd = open(getPath(dir).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    const bool written = fd >= 0 && ::write(fd, record.data(), record.size()) == static_cast<ssize_t>(record.size());
+    if(fd >= 0) close(fd);
+    if(!written) std::cerr << "Warning: could not write golden digest to " << getPath(dir) << std::endl;
+    return written;
+  }
+
+  /**
+   * "hit", "stored", "miss" (failed, so not stored) or "not-stored" (not fully verified) for the first
+   * verification since the previous call, if it used the cache. Later runs of a benchmark hit the digest
+   * its first run stored, so their status would hide whether the digest is new.
+   */
+  std::optional<std::string> takeStatus() {
+    auto result = status;
+    status.reset();
+    return result;
+  }
+
+  void setStatus(const std::string& s) {
+    if(!status) status = s;
+  }
+
+private:
+  std::mutex mutex;
+  bool loaded = false;
+  std::unordered_map<std::string, Digest> digests;
+  std::optional<std::string> status;
+
+  static std::string getPath(const std::string& dir) { return dir + "/digests.bin"; }
+
+  void load(const std::string& dir) {
+    if(loaded) return;
+    loaded = true;
+
+    const int fd = open(getPath(dir).c_str(), O_RDONLY);
+    if(fd < 0) return;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      return;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED) {
+      std::cerr << "Warning: could not map golden digests " << getPath(dir) << ", ignoring them" << std::endl;
+      return;
+    }
+
+    const char* data = static_cast<const char*>(mapping);
+    std::size_t offset = 0;
+    const auto read = [&](void* out, std::size_t bytes) {
+      if(offset + bytes > size) return false;
+      std::memcpy(out, data + offset, bytes);
+      offset += bytes;
+      return true;
+    };
+    // A truncated last record (e.g. from an interrupted run) is ignored
+    while(offset < size) {
+      std::uint32_t key_length = 0, sample_count = 0;
+      Digest digest;
+      if(!read(&key_length, sizeof(key_length)) || offset + key_length > size) break;
+      std::string key{data + offset, key_length};
+      offset += key_length;
+      if(!read(&digest.hash, sizeof(digest.hash)) || !read(&digest.sum, sizeof(digest.sum)) ||
+          !read(&sample_count, sizeof(sample_count))) {
+        break;
+      }
+      digest.samples.resize(sample_count);
+      if(!read(digest.samples.data(), sample_count * sizeof(double))) break;
+      digests[key] = std::move(digest);
+    }
+    munmap(mapping, size);
+  }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+  #include <sched.h>
+#endif
+
+/**
+ * Parallel host-side initialization of benchmark inputs.
+ *
+ * A std::vector<T>(n) zero-fills its memory on the calling thread, so all pages are
+ * first touched (and thus placed) on that thread's NUMA node, and the fill is serial.
+ * HostVector leaves trivial elements uninitialized on allocation; the make* functions
+ * below then write every element exactly once from a set of threads, each working on a
+ * contiguous chunk. Pages end up on the NUMA nodes of the threads that wrote them,
+ * which follow the process affinity (see --pin and --numa).
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+class DefaultInitAllocator : public Allocator
+{
+  using traits = std::allocator_traits<Allocator>;
+
+public:
+  template <typename U>
+  struct rebind {
+    using other = DefaultInitAllocator<U, typename traits::template rebind_alloc<U>>;
+  };
+
+  using Allocator::Allocator;
+
+  template <typename U>
+  void construct(U* ptr) noexcept(std::is_nothrow_default_constructible_v<U>) {
+    ::new(static_cast<void*>(ptr)) U;
+  }
+
+  template <typename U, typename... Args>
+  void construct(U* ptr, Args&&... args) {
+    traits::construct(static_cast<Allocator&>(*this), ptr, std::forward<Args>(args)...);
+  }
+};
+
+template <typename T>
+using HostVector = std::vector<T, DefaultInitAllocator<T>>;
+
+// Number of CPUs this process may run on
+inline std::size_t getHostInitThreads()
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if(sched_getaffinity(0, sizeof(set), &set) == 0) {
+    return std::max(1, CPU_COUNT(&set));
+  }
+#endif
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls f(i) for all i in [0, n), splitting the range into one contiguous chunk per thread.
+// Ranges below min_chunk iterations per thread are not worth spawning threads for.
+template <typename F>
+void parallelFor(std::size_t n, F&& f, std::size_t min_chunk = 1 << 14)
+{
+  const std::size_t num_threads = std::min(getHostInitThreads(), std::max<std::size_t>(1, n / min_chunk));
+  const std::size_t chunk = (n + num_threads - 1) / num_threads;
+
+  const auto work = [&](std::size_t begin) {
+    const std::size_t end = std::min(n, begin + chunk);
+    for(std::size_t i = begin; i < end; ++i) f(i);
+  };
+
+  std::vector<std::thread> threads;
+  for(std::size_t t = 1; t < num_threads; ++t) {
+    threads.emplace_back(work, t * chunk);
+  }
+  work(0);
+  for(auto& thread : threads) thread.join();
+}
+
+// A vector of n elements initialized in parallel with f(i)
+template <typename T, typename F, std::enable_if_t<std::is_invocable_v<F&, std::size_t>, int> = 0>
+HostVector<T> makeHostVector(std::size_t n, F&& f)
+{
+  HostVector<T> vec(n);
+  parallelFor(n, [&](std::size_t i) { vec[i] = f(i); });
+  return vec;
+}
+
+// A vector of n elements initialized in parallel with value
+template <typename T>
+HostVector<T> makeHostVector(std::size_t n, const T& value = T{})
+{
+  return makeHostVector<T>(n, [&](std::size_t) { return value; });
+}
+
+// A row-major rows x cols matrix initialized in parallel with f(i, j); rows are distributed among threads
+template <typename T, typename F>
+HostVector<T> makeHostMatrix(std::size_t rows, std::size_t cols, F&& f)
+{
+  HostVector<T> vec(rows * cols);
+  parallelFor(rows, [&](std::size_t i) {
+    for(std::size_t j = 0; j < cols; ++j) vec[i * cols + j] = f(i, j);
+  }, std::max<std::size_t>(1, (1 << 14) / std::max<std::size_t>(1, cols)));
+  return vec;
+}
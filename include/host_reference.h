@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "host_init.h"
+#include "input_file.h"
+
+/**
+ * Multithreaded CPU reference kernels for verification.
+ *
+ * Every kernel computes a rectangular block [row_begin, row_end) x
+ * [col_begin, col_end) of its result and writes it row-major to out, so it
+ * can serve as a block reference of verifyPartitions() that only computes the
+ * partition a node checks. Rows are distributed among threads with
+ * parallelFor() (see host_init.h), the loops are cache-blocked and, where the
+ * data layout allows, their innermost loop runs over contiguous columns
+ * without branches, so that the compiler vectorizes it.
+ *
+ * Results are accumulated in the order of the naive device kernels where that
+ * does not prevent vectorization, but are not bit-identical to them; verify
+ * with a tolerance.
+ */
+namespace host_reference {
+
+// A strided view of a row-major matrix; transposed() swaps the strides
+template <typename T>
+struct MatrixView {
+  const T* data = nullptr;
+  std::size_t row_stride = 0;
+  std::size_t col_stride = 1;
+
+  const T& operator()(std::size_t i, std::size_t j) const { return data[i * row_stride + j * col_stride]; }
+  MatrixView transposed() const { return {data, col_stride, row_stride}; }
+};
+
+// Rows per task and the tile of the depth and columns of b kept in cache
+inline constexpr std::size_t block_rows = 16;
+inline constexpr std::size_t block_depth = 256;
+inline constexpr std::size_t block_cols = 512;
+
+// out = alpha * a * b + beta * c, where a is (rows x depth) and b is (depth x cols). c may be null, beta is then ignored.
+template <typename T>
+void gemm(std::size_t row_begin, std::size_t row_end, std::size_t col_begin, std::size_t col_end, std::size_t depth,
+    T alpha, MatrixView<T> a, MatrixView<T> b, T beta, MatrixView<T> c, T* out) {
+  const std::size_t cols = col_end - col_begin;
+  const std::size_t num_blocks = (row_end - row_begin + block_rows - 1) / block_rows;
+
+  parallelFor(num_blocks, [&](std::size_t block) {
+    const std::size_t i_begin = row_begin + block * block_rows;
+    const std::size_t i_end = std::min(row_end, i_begin + block_rows);
+    std::fill(out + (i_begin - row_begin) * cols, out + (i_end - row_begin) * cols, T{0});
+
+    // A tile of b with contiguous columns; only copied if b is strided (e.g. transposed)
+    std::vector<T> packed;
+    for(std::size_t j0 = col_begin; j0 < col_end; j0 += block_cols) {
+      const std::size_t jn = std::min(col_end, j0 + block_cols) - j0;
+      for(std::size_t k0 = 0; k0 < depth; k0 += block_depth) {
+        const std::size_t k1 = std::min(depth, k0 + block_depth);
+        if(b.col_stride != 1) {
+          packed.resize((k1 - k0) * jn);
+          for(std::size_t k = k0; k < k1; ++k) {
+            for(std::size_t j = 0; j < jn; ++j) packed[(k - k0) * jn + j] = b(k, j0 + j);
+          }
+        }
+        for(std::size_t i = i_begin; i < i_end; ++i) {
+          T* o = out + (i - row_begin) * cols + (j0 - col_begin);
+          for(std::size_t k = k0; k < k1; ++k) {
+            const T a_ik = a(i, k);
+            const T* b_k = b.col_stride == 1 ? &b(k, j0) : &packed[(k - k0) * jn];
+            for(std::size_t j = 0; j < jn; ++j) o[j] += a_ik * b_k[j];
+          }
+        }
+      }
+    }
+
+    for(std::size_t i = i_begin; i < i_end; ++i) {
+      T* o = out + (i - row_begin) * cols;
+      for(std::size_t j = 0; j < cols; ++j) {
+        o[j] = alpha * o[j] + (c.data ? beta * c(i, col_begin + j) : T{0});
+      }
+    }
+  }, 1);
+}
+
+// out = alpha * a * x + beta * y for the rows [row_begin, row_end) of a (rows x cols). y may be null, beta is then ignored.
+template <typename T>
+void gemv(std::size_t row_begin, std::size_t row_end, std::size_t cols, T alpha, MatrixView<T> a, const T* x, T beta,
+    const T* y, T* out) {
+  const std::size_t num_blocks = (row_end - row_begin + block_rows - 1) / block_rows;
+  parallelFor(num_blocks, [&](std::size_t block) {
+    const std::size_t i_begin = row_begin + block * block_rows;
+    const std::size_t i_end = std::min(row_end, i_begin + block_rows);
+    T* o = out + (i_begin - row_begin);
+    std::fill(o, o + (i_end - i_begin), T{0});
+    if(a.col_stride == 1) {
+      // Rows are contiguous: one inner product per row
+      for(std::size_t i = i_begin; i < i_end; ++i) {
+        const T* a_i = &a(i, 0);
+        T sum = 0;
+        for(std::size_t j = 0; j < cols; ++j) sum += a_i[j] * x[j];
+        o[i - i_begin] = sum;
+      }
+    } else {
+      // Columns are contiguous (a transposed matrix): accumulate x[j] times column j
+      for(std::size_t j = 0; j < cols; ++j) {
+        const T* a_j = &a(i_begin, j);
+        const T x_j = x[j];
+        for(std::size_t i = 0; i < i_end - i_begin; ++i) o[i] += a_j[i * a.row_stride] * x_j;
+      }
+    }
+    for(std::size_t i = i_begin; i < i_end; ++i) {
+      o[i - i_begin] = alpha * o[i - i_begin] + (y ? beta * y[i] : T{0});
+    }
+  }, 1);
+}
+
+/**
+ * Weighted sum over the (2 * Radius + 1)^2 neighborhood of every element of a
+ * rows x cols matrix: 2D stencils such as Jacobi (a cross of weights) and the
+ * 3x3, 5x5 and 7x7 convolutions. weights are row-major, centered on the element.
+ * Neighbors outside of the matrix are clamped to the nearest border element.
+ */
+template <int Radius, typename T, typename W>
+void stencil2d(std::size_t row_begin, std::size_t row_end, std::size_t col_begin, std::size_t col_end,
+    std::size_t rows, std::size_t cols, const T* in, const W* weights, T* out) {
+  constexpr int width = 2 * Radius + 1;
+  const std::size_t out_cols = col_end - col_begin;
+  // Columns whose whole neighborhood lies inside the matrix
+  const std::size_t inner_begin = std::clamp<std::size_t>(Radius, col_begin, col_end);
+  const std::size_t inner_end = std::clamp<std::size_t>(cols > Radius ? cols - Radius : 0, inner_begin, col_end);
+  const auto clampIndex = [](std::ptrdiff_t x, std::size_t n) {
+    return static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(x, 0, static_cast<std::ptrdiff_t>(n) - 1));
+  };
+
+  parallelFor(row_end - row_begin, [&](std::size_t r) {
+    const std::size_t i = row_begin + r;
+    T* o = out + r * out_cols;
+    std::fill(o, o + out_cols, T{0});
+    for(int di = -Radius; di <= Radius; ++di) {
+      const T* row = in + clampIndex(static_cast<std::ptrdiff_t>(i) + di, rows) * cols;
+      for(int dj = -Radius; dj <= Radius; ++dj) {
+        const T w = static_cast<T>(weights[(di + Radius) * width + dj + Radius]);
+        const auto border = [&](std::size_t j) {
+          o[j - col_begin] += w * row[clampIndex(static_cast<std::ptrdiff_t>(j) + dj, cols)];
+        };
+        for(std::size_t j = col_begin; j < inner_begin; ++j) border(j);
+        for(std::size_t j = inner_begin; j < inner_end; ++j) o[j - col_begin] += w * row[j + dj];
+        for(std::size_t j = inner_end; j < col_end; ++j) border(j);
+      }
+    }
+  }, std::max<std::size_t>(1, (1 << 12) / std::max<std::size_t>(1, out_cols)));
+}
+
+/**
+ * Weighted sum over the (2 * Radius + 1)^3 neighborhood of every element of a
+ * depth x rows x cols volume, with weights indexed [dz][dy][dx]. The block is
+ * given in the 2D view of the volume used by verifyPartitions(): view row
+ * z * rows + y, column x. Neighbors outside of the volume are clamped.
+ */
+template <int Radius, typename T, typename W>
+void stencil3d(std::size_t row_begin, std::size_t row_end, std::size_t col_begin, std::size_t col_end,
+    std::size_t depth, std::size_t rows, std::size_t cols, const T* in, const W* weights, T* out) {
+  constexpr int width = 2 * Radius + 1;
+  const std::size_t out_cols = col_end - col_begin;
+  const auto clampIndex = [](std::ptrdiff_t x, std::size_t n) {
+    return static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(x, 0, static_cast<std::ptrdiff_t>(n) - 1));
+  };
+
+  parallelFor(row_end - row_begin, [&](std::size_t r) {
+    const std::size_t z = (row_begin + r) / rows;
+    const std::size_t y = (row_begin + r) % rows;
+    T* o = out + r * out_cols;
+    std::fill(o, o + out_cols, T{0});
+    for(int dz = -Radius; dz <= Radius; ++dz) {
+      const T* plane = in + clampIndex(static_cast<std::ptrdiff_t>(z) + dz, depth) * rows * cols;
+      for(int dy = -Radius; dy <= Radius; ++dy) {
+        const T* row = plane + clampIndex(static_cast<std::ptrdiff_t>(y) + dy, rows) * cols;
+        for(int dx = -Radius; dx <= Radius; ++dx) {
+          const T w = static_cast<T>(weights[((dz + Radius) * width + dy + Radius) * width + dx + Radius]);
+          for(std::size_t j = 0; j < out_cols; ++j) {
+            o[j] += w * row[clampIndex(static_cast<std::ptrdiff_t>(col_begin + j) + dx, cols)];
+          }
+        }
+      }
+    }
+  }, std::max<std::size_t>(1, (1 << 12) / std::max<std::size_t>(1, out_cols)));
+}
+
+// Median of the (2 * Radius + 1)^2 neighborhood of every element, with neighbors clamped to the border
+template <int Radius, typename T>
+void median(std::size_t row_begin, std::size_t row_end, std::size_t col_begin, std::size_t col_end,
+    std::size_t rows, std::size_t cols, const T* in, T* out) {
+  constexpr int width = 2 * Radius + 1;
+  const std::size_t out_cols = col_end - col_begin;
+  const auto clampIndex = [](std::ptrdiff_t x, std::size_t n) {
+    return static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(x, 0, static_cast<std::ptrdiff_t>(n) - 1));
+  };
+
+  parallelFor(row_end - row_begin, [&](std::size_t r) {
+    const std::size_t i = row_begin + r;
+    T window[width * width];
+    for(std::size_t j = col_begin; j < col_end; ++j) {
+      int k = 0;
+      for(int di = -Radius; di <= Radius; ++di) {
+        const T* row = in + clampIndex(static_cast<std::ptrdiff_t>(i) + di, rows) * cols;
+        for(int dj = -Radius; dj <= Radius; ++dj) window[k++] = row[clampIndex(static_cast<std::ptrdiff_t>(j) + dj, cols)];
+      }
+      std::nth_element(window, window + width * width / 2, window + width * width);
+      out[r * out_cols + j - col_begin] = window[width * width / 2];
+    }
+  }, std::max<std::size_t>(1, (1 << 10) / std::max<std::size_t>(1, out_cols)));
+}
+
+} // namespace host_reference
+
+/**
+ * The host copy of a rows x cols benchmark input for a reference computation:
+ * the memory-mapped --input-file if there is one, otherwise the values of the
+ * generator that initialized the buffer (computed with makeHostMatrix).
+ */
+template <typename T>
+class HostInput
+{
+public:
+  template <typename Generator>
+  HostInput(std::size_t rows, std::size_t cols, std::shared_ptr<const InputFile> file, Generator gen)
+      : file(std::move(file)), cols(cols) {
+    if(!this->file) generated = makeHostMatrix<T>(rows, cols, gen);
+  }
+
+  const T* data() const { return file ? file->template getData<T>() : generated.data(); }
+  host_reference::MatrixView<T> view() const { return {data(), cols}; }
+
+private:
+  std::shared_ptr<const InputFile> file;
+  std::size_t cols;
+  HostVector<T> generated;
+};
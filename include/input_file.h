@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <celerity/celerity.h>
+
+/**
+ * A memory-mapped input dataset given with --input-file.
+ *
+ * Files in the NumPy .npy format (versions 1 to 3, C order) carry their element
+ * type and shape, which are checked against the buffer they initialize. Any
+ * other file is treated as raw, headerless data in the buffer's element type
+ * and row-major order, of which only the size can be checked.
+ *
+ * Mapping the file does not read it. Buffers are filled by a host task, so
+ * every node only touches (and thus reads) the pages of its own partition.
+ */
+class InputFile
+{
+public:
+  InputFile(const std::string& path) : path(path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+      throw std::invalid_argument{"Could not open input file " + path};
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      throw std::invalid_argument{"Could not read input file " + path};
+    }
+    file_size = static_cast<std::size_t>(st.st_size);
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED) {
+      throw std::invalid_argument{"Could not map input file " + path};
+    }
+    mapped = static_cast<const char*>(mapping);
+    parseNpyHeader();
+  }
+
+  ~InputFile() { munmap(const_cast<char*>(mapped), file_size); }
+
+  InputFile(const InputFile&) = delete;
+  InputFile& operator=(const InputFile&) = delete;
+
+  const std::string& getPath() const { return path; }
+
+  // Throws if the file cannot initialize a buffer of type T and the given range
+  template <typename T, int Dims>
+  void validate(celerity::range<Dims> range) const {
+    std::size_t elements = 1;
+    std::vector<std::size_t> expected_shape;
+    for(int d = 0; d < Dims; ++d) {
+      elements *= range[d];
+      // Vectors are stored as (n, 1) buffers by some benchmarks
+      if(range[d] != 1) expected_shape.push_back(range[d]);
+    }
+
+    if(is_npy) {
+      if(descr != getDescr<T>()) {
+        throw std::invalid_argument{path + " has element type " + descr + ", expected " + getDescr<T>()};
+      }
+      if(fortran_order) {
+        throw std::invalid_argument{path + " is in Fortran order, expected C order"};
+      }
+      std::vector<std::size_t> file_shape;
+      for(std::size_t extent : shape) {
+        if(extent != 1) file_shape.push_back(extent);
+      }
+      if(file_shape != expected_shape) {
+        throw std::invalid_argument{path + " has shape " + formatShape(shape) + ", expected " + formatShape(expected_shape)};
+      }
+    }
+    if(file_size - data_offset != elements * sizeof(T)) {
+      throw std::invalid_argument{path + " has " + std::to_string(file_size - data_offset) + " bytes of data, expected " +
+                                  std::to_string(elements * sizeof(T))};
+    }
+  }
+
+  template <typename T>
+  const T* getData() const {
+    return reinterpret_cast<const T*>(mapped + data_offset);
+  }
+
+private:
+  std::string path;
+  const char* mapped = nullptr;
+  std::size_t file_size = 0;
+  std::size_t data_offset = 0;
+
+  bool is_npy = false;
+  std::string descr;
+  bool fortran_order = false;
+  std::vector<std::size_t> shape;
+
+  void parseNpyHeader() {
+    static const char magic[] = "\x93NUMPY";
+    if(file_size < 10 || std::memcmp(mapped, magic, 6) != 0) return;
+
+    const auto byte = [&](std::size_t i) { return static_cast<std::size_t>(static_cast<unsigned char>(mapped[i])); };
+    const std::size_t major = byte(6);
+    std::size_t header_length = 0, header_begin = 0;
+    if(major == 1) {
+      header_length = byte(8) | byte(9) << 8;
+      header_begin = 10;
+    } else if(major == 2 || major == 3) {
+      if(file_size < 12) throw std::invalid_argument{path + " has a truncated .npy header"};
+      header_length = byte(8) | byte(9) << 8 | byte(10) << 16 | byte(11) << 24;
+      header_begin = 12;
+    } else {
+      throw std::invalid_argument{path + " has unsupported .npy version " + std::to_string(major)};
+    }
+    if(header_begin + header_length > file_size) {
+      throw std::invalid_argument{path + " has a truncated .npy header"};
+    }
+
+    const std::string header{mapped + header_begin, header_length};
+    static const std::regex descr_re{R"re('descr':\s*'([^']*)')re"};
+    static const std::regex order_re{R"re('fortran_order':\s*(True|False))re"};
+    static const std::regex shape_re{R"re('shape':\s*\(([^)]*)\))re"};
+    std::smatch descr_match, order_match, shape_match;
+    if(!std::regex_search(header, descr_match, descr_re) || !std::regex_search(header, order_match, order_re) ||
+        !std::regex_search(header, shape_match, shape_re)) {
+      throw std::invalid_argument{path + " has an invalid .npy header: " + header};
+    }
+
+    is_npy = true;
+    descr = descr_match[1];
+    // Native byte order and single bytes are written as '=' and '|'; this is little endian only
+    if(!descr.empty() && (descr[0] == '=' || descr[0] == '|')) descr[0] = '<';
+    fortran_order = order_match[1] == "True";
+    std::stringstream extents(shape_match[1].str());
+    std::string extent;
+    while(std::getline(extents, extent, ',')) {
+      if(extent.find_first_not_of(" ") != std::string::npos) shape.push_back(std::stoull(extent));
+    }
+    data_offset = header_begin + header_length;
+  }
+
+  template <typename T>
+  static std::string getDescr() {
+    static_assert(std::is_arithmetic_v<T>, "Input files hold arithmetic types only");
+    const char kind = std::is_floating_point_v<T> ? 'f' : (std::is_signed_v<T> ? 'i' : 'u');
+    return std::string{"<"} + kind + std::to_string(sizeof(T));
+  }
+
+  static std::string formatShape(const std::vector<std::size_t>& shape) {
+    std::string result = "(";
+    for(std::size_t i = 0; i < shape.size(); ++i) {
+      result += (i == 0 ? "" : ", ") + std::to_string(shape[i]);
+    }
+    return result + ")";
+  }
+};
+
+// Copies the row-major contents of file into buf; every node reads the partition it is assigned
+template <typename T, int Dims>
+void readInputFile(celerity::distr_queue& queue, celerity::buffer<T, Dims> buf, std::shared_ptr<const InputFile> file) {
+  const auto range = buf.get_range();
+  file->template validate<T>(range);
+  queue.submit([=](celerity::handler& cgh) {
+    celerity::accessor out{buf, cgh, celerity::access::one_to_one{}, celerity::write_only_host_task, celerity::no_init};
+    cgh.host_task(range, [=](celerity::partition<Dims> part) {
+      const T* data = file->template getData<T>();
+      const auto sr = part.get_subrange();
+      if constexpr(Dims == 1) {
+        for(std::size_t i = sr.offset[0]; i < sr.offset[0] + sr.range[0]; ++i) {
+          out[i] = data[i];
+        }
+      } else if constexpr(Dims == 2) {
+        for(std::size_t i = sr.offset[0]; i < sr.offset[0] + sr.range[0]; ++i) {
+          for(std::size_t j = sr.offset[1]; j < sr.offset[1] + sr.range[1]; ++j) {
+            out[{i, j}] = data[i * range[1] + j];
+          }
+        }
+      } else {
+        for(std::size_t i = sr.offset[0]; i < sr.offset[0] + sr.range[0]; ++i) {
+          for(std::size_t j = sr.offset[1]; j < sr.offset[1] + sr.range[1]; ++j) {
+            for(std::size_t k = sr.offset[2]; k < sr.offset[2] + sr.range[2]; ++k) {
+              out[{i, j, k}] = data[(i * range[1] + j) * range[2] + k];
+            }
+          }
+        }
+      }
+    });
+  });
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+
+#include <celerity/celerity.h>
+
+#include "command_line.h"
+
+/**
+ * Per-kernel timing for Celerity, which does not expose SYCL events.
+ *
+ * Benchmarks submit their command groups through KernelProfiler::submit() with a
+ * tag naming the kernel. With --kernel-profiling, every tagged submission is
+ * fenced by a node-local sync (QueueManager::localSync()) before and after it,
+ * and the time in between is added to the tag's time of the current run. The
+ * harness reports the sum as kernel-time and each tag as kernel-time-<tag>.
+ * As the fences do not wait for the other nodes, the times are those of the
+ * node's own share of the kernel, including waits for data from other nodes.
+ *
+ * The fences serialize the kernels and the runtime, so run-time is inflated
+ * while profiling is enabled. Without the flag, submit() is a plain queue.submit().
+ */
+class KernelProfiler
+{
+public:
+  static KernelProfiler& getInstance() {
+    static KernelProfiler inst;
+    return inst;
+  }
+
+  template <typename... Args>
+  static void submit(celerity::distr_queue& queue, const std::string& tag, Args&&... args) {
+    KernelProfiler& profiler = getInstance();
+    if(!profiler.enabled) {
+      queue.submit(std::forward<Args>(args)...);
+      return;
+    }
+
+    QueueManager::localSync();
+    const auto before = std::chrono::high_resolution_clock::now();
+    queue.submit(std::forward<Args>(args)...);
+    QueueManager::localSync();
+    const auto after = std::chrono::high_resolution_clock::now();
+    profiler.timings[tag] += std::chrono::duration_cast<std::chrono::nanoseconds>(after - before);
+  }
+
+  void setEnabled(bool enable) { enabled = enable; }
+  bool isEnabled() const { return enabled; }
+
+  // Returns the accumulated time per tag since the last call and resets it
+  std::map<std::string, std::chrono::nanoseconds> takeTimings() {
+    return std::exchange(timings, {});
+  }
+
+  KernelProfiler(KernelProfiler const&) = delete;
+  void operator=(KernelProfiler const&) = delete;
+
+private:
+  KernelProfiler() {}
+
+  bool enabled = false;
+  std::map<std::string, std::chrono::nanoseconds> timings;
+};
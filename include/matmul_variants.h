@@ -0,0 +1,70 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include <celerity/celerity.h>
+
+#include "benchmark_variants.h"
+
+/**
+ * Kernel variants of the matrix multiplication benchmarks
+ * (single-kernel/matmul.cc and runtime/matmulchain.cc).
+ *
+ * Each variant is a tag type carrying its compile-time parameters, on which
+ * the benchmarks overload multiply(). They are selected at runtime with
+ * --variant=naive,tiled,blocked and, for the tiled kernels, --tile=8..32. The naive
+ * kernel keeps the plain benchmark name, the others append their parameters.
+ */
+namespace matmul_variants {
+
+// One work-item per element of the result, reading a and b from global memory
+struct Naive {
+  static constexpr const char* name = "naive";
+  static std::string getSuffix() { return ""; }
+};
+
+// Work-groups of TileSize x TileSize items stage tiles of a and b in local memory
+template <int TileSize>
+struct Tiled {
+  static constexpr const char* name = "tiled";
+  static constexpr int tile_size = TileSize;
+  static std::string getSuffix() { return "_Tiled_" + std::to_string(TileSize); }
+};
+
+// Every work-item computes a Rows x Cols block of the result in registers, unrolling the inner product KUnroll times
+template <int Rows, int Cols, int KUnroll>
+struct Blocked {
+  static constexpr const char* name = "blocked";
+  static constexpr int rows = Rows;
+  static constexpr int cols = Cols;
+  static constexpr int k_unroll = KUnroll;
+  static std::string getSuffix() {
+    return "_Blocked_" + std::to_string(Rows) + "x" + std::to_string(Cols) + "_k" + std::to_string(KUnroll);
+  }
+};
+
+// Calls f(Variant{}) for every variant selected on the command line
+template <class App, class F>
+void forEachSelected(const App& app, F&& f) {
+  if(app.shouldRunVariant(Naive::name)) f(Naive{});
+#if CELERITY_FEATURE_LOCAL_ACCESSOR
+  if(app.shouldRunVariant(Tiled<8>::name)) {
+    forEachValue(ValueList<8, 16, 32>{}, [&](auto tile) {
+      if(app.shouldRunTileSize(tile)) f(Tiled<decltype(tile)::value>{});
+    });
+  }
+#else
+  if(app.isVariantRequested(Tiled<8>::name) && celerity::detail::runtime::get_instance().is_master_node()) {
+    std::cerr << "Warning: --variant=tiled is not available, this build has no local accessors (CELERITY_FEATURE_LOCAL_ACCESSOR)"
+              << std::endl;
+  }
+#endif
+  if(app.shouldRunVariant(Blocked<1, 1, 1>::name)) {
+    f(Blocked<2, 4, 4>{});
+    f(Blocked<4, 4, 4>{});
+    f(Blocked<4, 8, 4>{});
+  }
+}
+
+} // namespace matmul_variants
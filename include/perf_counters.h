@@ -0,0 +1,185 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <mpi.h>
+
+#include "benchmark_hook.h"
+#include "benchmark_traits.h"
+#include "command_line.h"
+#include "result_consumer.h"
+
+/**
+ * Counts CPU hardware events of this process with perf_event_open(2) while the
+ * kernels are running, i.e. between preKernel() and postKernel().
+ *
+ * One counter per event is opened for every thread that exists at atInit()
+ * (the runtime's worker threads) with inherit set, so that threads spawned
+ * later are counted as well. Only user-space events are counted, which keeps
+ * the hook usable with the default perf_event_paranoid setting. Events that
+ * the CPU or the kernel do not support are reported as N/A.
+ *
+ * Every rank counts the events of its own process. The counts are summed over
+ * all ranks in gatherResults() and reported as per-run means. Misses are also
+ * normalized by the number of elements the benchmark processes to make runs with
+ * different sizes comparable. Benchmarks that work on more than problem_size
+ * elements (e.g. n x n matrices) report their count through getNumElements().
+ */
+template <class Benchmark>
+class PerfCounterMeasurement : public BenchmarkHook
+{
+public:
+  PerfCounterMeasurement(const BenchmarkArgs& args) : num_elements(getNumElements(args)) {
+    events = {
+      {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, {}},
+      {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, {}},
+      {"llc-misses", PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_MISS), {}},
+      {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, {}},
+      {"dtlb-misses", PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_RESULT_MISS), {}},
+    };
+  }
+
+  PerfCounterMeasurement(const PerfCounterMeasurement&) = delete;
+  PerfCounterMeasurement& operator=(const PerfCounterMeasurement&) = delete;
+
+  ~PerfCounterMeasurement() {
+    for(auto& e : events) {
+      for(int fd : e.fds) close(fd);
+    }
+  }
+
+  virtual void atInit() override {
+    const auto tids = getThreadIds();
+    for(auto& e : events) {
+      for(pid_t tid : tids) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = e.type;
+        attr.config = e.config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+        // Threads may have exited in the meantime; a failure on all threads marks the event unsupported
+        if(fd >= 0) e.fds.push_back(fd);
+      }
+    }
+  }
+
+  virtual void preSetup() override {}
+  virtual void postSetup() override {}
+
+  virtual void preKernel() override {
+    for(auto& e : events) {
+      for(int fd : e.fds) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  virtual void postKernel() override {
+    for(auto& e : events) {
+      for(int fd : e.fds) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    ++runs;
+  }
+
+  virtual void gatherResults() override {
+    std::vector<double> local, unsupported;
+    for(const auto& e : events) {
+      local.push_back(readCount(e));
+      unsupported.push_back(local.back() < 0 ? 1.0 : 0.0);
+    }
+    counts.assign(events.size(), 0.0);
+    std::vector<double> unsupported_anywhere(events.size(), 0.0);
+    MPI_Reduce(local.data(), counts.data(), static_cast<int>(events.size()), MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(unsupported.data(), unsupported_anywhere.data(), static_cast<int>(events.size()), MPI_DOUBLE, MPI_MAX,
+        0, MPI_COMM_WORLD);
+    // An event that is missing on any rank would give a partial sum
+    for(std::size_t i = 0; i < events.size(); ++i) {
+      if(unsupported_anywhere[i] > 0) counts[i] = -1.0;
+    }
+  }
+
+  virtual void emitResults(ResultConsumer& consumer) override {
+    const auto count = [&](std::size_t i) { return counts[i] / static_cast<double>(runs); };
+    const auto emit = [&](const std::string& name, bool available, double value) {
+      consumer.consumeResult(name, available ? std::to_string(value) : "N/A");
+    };
+
+    for(std::size_t i = 0; i < events.size(); ++i) {
+      emit("perf-" + events[i].name, counts[i] >= 0 && runs > 0, count(i));
+    }
+    emit("perf-ipc", counts[0] > 0 && counts[1] >= 0 && runs > 0, counts[1] / counts[0]);
+    for(std::size_t i = 2; i < events.size(); ++i) {
+      emit("perf-" + events[i].name + "-per-element", counts[i] >= 0 && runs > 0 && num_elements > 0,
+          count(i) / static_cast<double>(num_elements));
+    }
+  }
+
+private:
+  struct Event {
+    std::string name;
+    std::uint32_t type;
+    std::uint64_t config;
+    std::vector<int> fds;
+  };
+
+  std::size_t num_elements;
+  std::size_t runs = 0;
+  std::vector<Event> events;
+  // Summed over all ranks, negative if unsupported (master node only)
+  std::vector<double> counts;
+
+  static std::size_t getNumElements(const BenchmarkArgs& args) {
+    if constexpr(cl::sycl::detail::BenchmarkTraits<Benchmark>::hasGetNumElements) {
+      return Benchmark::getNumElements(args);
+    } else {
+      return args.problem_size;
+    }
+  }
+
+  static std::uint64_t cacheEvent(std::uint64_t cache, std::uint64_t result) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+  }
+
+  static std::vector<pid_t> getThreadIds() {
+    std::vector<pid_t> tids;
+    if(DIR* dir = opendir("/proc/self/task")) {
+      while(const dirent* entry = readdir(dir)) {
+        if(entry->d_name[0] != '.') tids.push_back(static_cast<pid_t>(std::stol(entry->d_name)));
+      }
+      closedir(dir);
+    }
+    return tids;
+  }
+
+  // Sum over all threads, scaled up if the kernel had to multiplex the counters. Negative if unsupported.
+  static double readCount(const Event& e) {
+    if(e.fds.empty()) return -1.0;
+    double total = 0.0;
+    for(int fd : e.fds) {
+      std::uint64_t values[3] = {0, 0, 0};
+      if(read(fd, values, sizeof(values)) != sizeof(values)) return -1.0;
+      if(values[2] > 0) {
+        total += static_cast<double>(values[0]) * static_cast<double>(values[1]) / static_cast<double>(values[2]);
+      }
+    }
+    return total;
+  }
+};
+
+#endif
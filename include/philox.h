@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Philox4x32-10 counter-based random number generator (Salmon et al., "Parallel
+ * Random Numbers: As Easy as 1, 2, 3", SC'11).
+ *
+ * Each call maps a 128 bit counter and a 64 bit key to 128 random bits without
+ * any state, so the value of an element only depends on (seed, index) and is the
+ * same no matter which node or work item computes it. Usable in kernels and on
+ * the host.
+ */
+class Philox4x32
+{
+public:
+  using Counter = std::array<std::uint32_t, 4>;
+  using Key = std::array<std::uint32_t, 2>;
+
+  static Counter generate(Counter ctr, Key key) {
+    for(int round = 0; round < 10; ++round) {
+      if(round > 0) {
+        key[0] += 0x9E3779B9u;
+        key[1] += 0xBB67AE85u;
+      }
+      const std::uint64_t p0 = static_cast<std::uint64_t>(0xD2511F53u) * ctr[0];
+      const std::uint64_t p1 = static_cast<std::uint64_t>(0xCD9E8D57u) * ctr[2];
+      ctr = {static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<std::uint32_t>(p1),
+          static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<std::uint32_t>(p0)};
+    }
+    return ctr;
+  }
+
+  // The random bits of element (i, j) of the stream given by seed
+  static Counter generate(std::uint64_t seed, std::uint64_t i, std::uint64_t j = 0) {
+    return generate(Counter{static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(i >> 32),
+                        static_cast<std::uint32_t>(j), static_cast<std::uint32_t>(j >> 32)},
+        Key{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)});
+  }
+
+  // Uniform in [0, 1) with 24 random bits
+  static float toUniformFloat(std::uint32_t bits) { return static_cast<float>(bits >> 8) * 0x1.0p-24f; }
+
+  // Uniform in [0, 1) with 53 random bits
+  static double toUniformDouble(std::uint32_t high, std::uint32_t low) {
+    const std::uint64_t bits = (static_cast<std::uint64_t>(high) << 32 | low) >> 11;
+    return static_cast<double>(bits) * 0x1.0p-53;
+  }
+};
@@ -2,6 +2,10 @@
 #include <celerity/celerity.h>
 #include <memory>
 
+#include "command_line.h"
+#include "device_generators.h"
+#include "input_file.h"
+
 template<class AccType>
 class InitializationDummyKernel
 {
@@ -31,6 +35,29 @@ public:
     buff = std::make_shared<celerity::buffer<T, Dimensions>>(data, r);
   }
 
+  // Creates the buffer and fills it on the device with one of the generators of device_generators.h
+  template <typename Generator>
+  void initialize(celerity::range<Dimensions> r, Generator gen) {
+    buff = std::make_shared<celerity::buffer<T, Dimensions>>(r);
+    generate(QueueManager::getInstance(), *buff, gen);
+  }
+
+  // Creates the buffer and reads it from a memory-mapped --input-file
+  void initialize(celerity::range<Dimensions> r, std::shared_ptr<const InputFile> file) {
+    buff = std::make_shared<celerity::buffer<T, Dimensions>>(r);
+    readInputFile(QueueManager::getInstance(), *buff, file);
+  }
+
+  // Reads the buffer from file if one is given, otherwise fills it with gen
+  template <typename Generator>
+  void initialize(celerity::range<Dimensions> r, std::shared_ptr<const InputFile> file, Generator gen) {
+    if(file) {
+      initialize(r, file);
+    } else {
+      initialize(r, gen);
+    }
+  }
+
   /*celerity::accessor get_accessor(celerity::handler& cgh, celerity::range<Dimensions> accessRange) {
     celerity::accessor result{buff.get(), cgh, celerity::access::one_to_one{}, celerity::read_only_host_task};
     return result;
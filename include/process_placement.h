@@ -0,0 +1,216 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * CPU pinning (--pin=compact|scatter|none) and NUMA memory policy
+ * (--numa=local|interleave|node:N) of the benchmark process.
+ *
+ * Both have to be applied before the Celerity runtime is initialized, so that
+ * the runtime's worker threads inherit the affinity mask and the memory policy.
+ * MPI is not initialized at that point, so the node-local rank is taken from
+ * the environment of the MPI launcher or Slurm.
+ *
+ * compact fills the NUMA nodes one after another with the node-local ranks,
+ * scatter distributes the ranks round-robin over the NUMA nodes. The ranks on
+ * a NUMA node split the node's available CPUs evenly. With compact, a single
+ * rank is confined to the first NUMA node; with scatter, ranks are spread over
+ * all NUMA nodes, so if there are fewer ranks than NUMA nodes, each rank gets
+ * every local_size-th NUMA node.
+ */
+class ProcessPlacement
+{
+public:
+  static void applyPinning(const std::string& mode) {
+    if(mode == "none") return;
+    if(mode != "compact" && mode != "scatter") {
+      throw std::invalid_argument{"Invalid --pin mode: " + mode};
+    }
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+
+    // Available CPUs per NUMA node
+    std::map<int, std::vector<int>> node_cpus;
+    for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if(CPU_ISSET(cpu, &allowed)) node_cpus[getNumaNodeOfCpu(cpu)].push_back(cpu);
+    }
+    if(node_cpus.empty()) return;
+
+    int local_rank = 0, local_size = 1;
+    if(!getLocalRankAndSize(local_rank, local_size)) {
+      std::cerr << "Warning: cannot determine the number of ranks on this node, --pin=" << mode << " is ignored"
+                << std::endl;
+      return;
+    }
+
+    std::vector<std::vector<int>> nodes;
+    for(auto& [node, node_cpu_list] : node_cpus) {
+      nodes.push_back(std::move(node_cpu_list));
+    }
+    const int num_nodes = static_cast<int>(nodes.size());
+
+    if(mode == "scatter" && local_size < num_nodes) {
+      std::vector<int> cpus;
+      for(int node = local_rank; node < num_nodes; node += local_size) {
+        cpus.insert(cpus.end(), nodes[node].begin(), nodes[node].end());
+      }
+      setAffinity(cpus);
+      return;
+    }
+
+    // Select the NUMA node of this rank, its slot on that node and the number of ranks sharing the node
+    int node = 0, slot = 0, ranks_on_node = 1;
+    if(mode == "compact") {
+      const int ranks_per_node = (local_size + num_nodes - 1) / num_nodes;
+      node = std::min(local_rank / ranks_per_node, num_nodes - 1);
+      slot = local_rank - node * ranks_per_node;
+      ranks_on_node = std::min(ranks_per_node, local_size - node * ranks_per_node);
+    } else {
+      node = local_rank % num_nodes;
+      slot = local_rank / num_nodes;
+      ranks_on_node = (local_size - node + num_nodes - 1) / num_nodes;
+    }
+
+    const auto& cpus = nodes[node];
+    const std::size_t share = std::max<std::size_t>(1, cpus.size() / std::max(1, ranks_on_node));
+    const std::size_t begin = std::min(cpus.size() - 1, static_cast<std::size_t>(slot) * share);
+    const std::size_t end = slot >= ranks_on_node - 1 ? cpus.size() : std::min(cpus.size(), begin + share);
+    setAffinity(std::vector<int>(cpus.begin() + begin, cpus.begin() + end));
+  }
+
+  static void applyNumaPolicy(const std::string& mode) {
+    long result = 0;
+    if(mode == "local") {
+      result = syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0);
+    } else if(mode == "interleave") {
+      unsigned long mask = 0;
+      for(int node = 0; node < static_cast<int>(sizeof(mask) * 8); ++node) {
+        if(std::ifstream{"/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"}) mask |= 1ul << node;
+      }
+      result = syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, &mask, sizeof(mask) * 8);
+    } else if(mode.rfind("node:", 0) == 0) {
+      const int node = std::stoi(mode.substr(5));
+      if(node < 0 || node >= static_cast<int>(sizeof(unsigned long) * 8)) {
+        throw std::invalid_argument{"Invalid NUMA node: " + mode};
+      }
+      const unsigned long mask = 1ul << node;
+      result = syscall(SYS_set_mempolicy, MPOL_BIND, &mask, sizeof(mask) * 8);
+    } else {
+      throw std::invalid_argument{"Invalid --numa mode: " + mode};
+    }
+    if(result != 0) {
+      throw std::runtime_error{"Could not apply NUMA policy " + mode};
+    }
+  }
+
+  // The affinity mask of the calling thread as a CPU list, e.g. "0-7+16-23". Ranges are joined with '+'
+  // rather than ',' so the list can go into a CSV column as is.
+  static std::string getAffinity() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) != 0) return "unknown";
+
+    std::ostringstream list;
+    for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if(!CPU_ISSET(cpu, &set)) continue;
+      int last = cpu;
+      while(last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &set)) ++last;
+      if(list.tellp() > 0) list << "+";
+      list << cpu;
+      if(last > cpu) list << "-" << last;
+      cpu = last;
+    }
+    return list.str();
+  }
+
+private:
+  static void setAffinity(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int cpu : cpus) CPU_SET(cpu, &set);
+    if(sched_setaffinity(0, sizeof(set), &set) != 0) {
+      throw std::runtime_error{"Could not set the CPU affinity"};
+    }
+  }
+
+  static int getNumaNodeOfCpu(int cpu) {
+    for(int node = 0; node < 1024; ++node) {
+      std::ifstream in{"/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"};
+      if(!in) {
+        if(node > 0) break;
+        return 0;
+      }
+      std::string cpulist;
+      in >> cpulist;
+      std::stringstream ranges(cpulist);
+      std::string range;
+      while(std::getline(ranges, range, ',')) {
+        const auto dash = range.find('-');
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        if(cpu >= first && cpu <= last) return node;
+      }
+    }
+    return 0;
+  }
+
+  /**
+   * Reads the node-local rank and rank count from the environment of the launcher that
+   * set the local rank. Without any launcher variables, the process is the only rank on
+   * its node. Returns false if the local rank is known but the rank count is not.
+   */
+  static bool getLocalRankAndSize(int& local_rank, int& local_size) {
+    local_rank = 0;
+    local_size = 1;
+    const std::pair<const char*, const char*> launchers[] = {
+        {"OMPI_COMM_WORLD_LOCAL_RANK", "OMPI_COMM_WORLD_LOCAL_SIZE"}, {"MPI_LOCALRANKID", "MPI_LOCALNRANKS"}};
+    for(const auto& [rank_name, size_name] : launchers) {
+      if(!std::getenv(rank_name)) continue;
+      local_rank = std::atoi(std::getenv(rank_name));
+      if(!std::getenv(size_name)) return false;
+      local_size = std::max(1, std::atoi(std::getenv(size_name)));
+      return true;
+    }
+    if(!std::getenv("SLURM_LOCALID")) return true;
+    local_rank = std::atoi(std::getenv("SLURM_LOCALID"));
+    const char* tasks_per_node = std::getenv("SLURM_TASKS_PER_NODE");
+    const char* node_id = std::getenv("SLURM_NODEID");
+    if(!tasks_per_node || !node_id) return false;
+    local_size = std::max(1, getSlurmTasksOnNode(tasks_per_node, std::atoi(node_id)));
+    return true;
+  }
+
+  // Task count of the given node from SLURM_TASKS_PER_NODE, e.g. node 2 of "4(x2),3" has 3 tasks
+  static int getSlurmTasksOnNode(const std::string& tasks_per_node, int node_id) {
+    std::stringstream groups(tasks_per_node);
+    std::string group;
+    while(std::getline(groups, group, ',')) {
+      const int tasks = std::atoi(group.c_str());
+      const auto repeat = group.find("(x");
+      const int nodes = repeat == std::string::npos ? 1 : std::atoi(group.c_str() + repeat + 2);
+      if(node_id < nodes) return tasks;
+      node_id -= nodes;
+    }
+    return 1;
+  }
+};
+
+#endif
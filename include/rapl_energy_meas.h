@@ -0,0 +1,174 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <mpi.h>
+
+#include "benchmark_hook.h"
+#include "benchmark_traits.h"
+#include "command_line.h"
+#include "result_consumer.h"
+#include "time_metrics.h"
+
+/**
+ * Measures the CPU package and DRAM energy consumed while the kernels are running
+ * (between preKernel() and postKernel()) through the intel-rapl powercap interface
+ * in /sys/class/powercap. Energies of all packages (and their DRAM domains) of the
+ * node are summed up. As the counters cover the whole machine, only the first rank
+ * of every physical node reads them, and gatherResults() sums the energies over
+ * all nodes. If no domain is readable on some node, the affected results are N/A.
+ *
+ * If the benchmark provides a roofline or throughput metric, the energy efficiency
+ * (GFLOP/J, GB/J, <unit>/J) is emitted as well, based on package plus DRAM energy.
+ */
+template <class Benchmark>
+class RaplEnergyMeasurement : public BenchmarkHook
+{
+public:
+  RaplEnergyMeasurement(const BenchmarkArgs& args) : args(args) {}
+
+  virtual void atInit() override {
+    // Ranks that share a node would count the same energy several times
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm);
+    int node_rank = 0;
+    MPI_Comm_rank(node_comm, &node_rank);
+    MPI_Comm_free(&node_comm);
+    reads_node = node_rank == 0;
+    if(!reads_node) return;
+
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    for(const auto& entry : fs::directory_iterator("/sys/class/powercap", ec)) {
+      const auto dir = entry.path();
+      if(dir.filename().string().rfind("intel-rapl:", 0) != 0) continue;
+
+      std::string name;
+      std::ifstream{dir / "name"} >> name;
+      Domain domain;
+      domain.energy_file = dir / "energy_uj";
+      if(name.rfind("package", 0) == 0) {
+        domain.kind = Domain::package;
+      } else if(name == "dram") {
+        domain.kind = Domain::dram;
+      } else {
+        continue;
+      }
+      std::ifstream{dir / "max_energy_range_uj"} >> domain.max_energy_uj;
+      if(readEnergy(domain.energy_file)) domains.push_back(domain);
+    }
+  }
+
+  virtual void preSetup() override {}
+  virtual void postSetup() override {}
+
+  virtual void preKernel() override {
+    for(auto& d : domains) {
+      d.before_uj = readEnergy(d.energy_file).value_or(0);
+    }
+    start = std::chrono::steady_clock::now();
+  }
+
+  virtual void postKernel() override {
+    elapsed += std::chrono::steady_clock::now() - start;
+    for(auto& d : domains) {
+      const auto after = readEnergy(d.energy_file);
+      if(!after) {
+        d.valid = false;
+        continue;
+      }
+      // The counter wraps around at max_energy_range_uj
+      const auto delta = *after >= d.before_uj ? *after - d.before_uj : *after + d.max_energy_uj - d.before_uj;
+      d.total_uj += delta;
+    }
+    ++runs;
+  }
+
+  virtual void gatherResults() override {
+    double local_j[2] = {0.0, 0.0};
+    // Ranks that do not read count as having both domains, so that only readers decide
+    int local_has[2] = {!reads_node, !reads_node};
+    for(const auto& d : domains) {
+      if(!d.valid) continue;
+      local_j[d.kind] += d.total_uj / 1.0e6;
+      local_has[d.kind] = 1;
+    }
+
+    double total_j[2] = {0.0, 0.0};
+    int all_have[2] = {0, 0};
+    MPI_Reduce(local_j, total_j, 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(local_has, all_have, 2, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+    package_j = total_j[Domain::package];
+    dram_j = total_j[Domain::dram];
+    has_package = all_have[Domain::package] != 0;
+    has_dram = all_have[Domain::dram] != 0;
+  }
+
+  virtual void emitResults(ResultConsumer& consumer) override {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    const bool available = runs > 0 && seconds > 0.0;
+    const auto emit = [&](const std::string& name, bool valid, double value, const std::string& unit) {
+      if(valid && available) {
+        consumer.consumeResult(name, std::to_string(value), unit);
+      } else {
+        consumer.consumeResult(name, "N/A", "");
+      }
+    };
+
+    // Energies are per-run means, the power is averaged over all runs
+    emit("energy-package", has_package, package_j / runs, "J");
+    emit("energy-dram", has_dram, dram_j / runs, "J");
+    emit("power-package", has_package, package_j / seconds, "W");
+    emit("power-dram", has_dram, dram_j / seconds, "W");
+
+    const double joules_per_run = (package_j + dram_j) / runs;
+    const bool has_energy = has_package && joules_per_run > 0.0;
+    if constexpr(cl::sycl::detail::BenchmarkTraits<Benchmark>::hasGetRooflineMetric) {
+      const auto rm = Benchmark::getRooflineMetric(args);
+      emit("energy-efficiency-flop", has_energy, rm.flop / 1.0e9 / joules_per_run, "GFLOP/J");
+      emit("energy-efficiency-bytes", has_energy, rm.bytes / 1.0e9 / joules_per_run, "GB/J");
+    } else {
+      consumer.consumeResult("energy-efficiency-flop", "N/A", "");
+      consumer.consumeResult("energy-efficiency-bytes", "N/A", "");
+    }
+    if constexpr(cl::sycl::detail::BenchmarkTraits<Benchmark>::hasGetThroughputMetric) {
+      const auto tpm = Benchmark::getThroughputMetric(args);
+      emit("energy-efficiency-throughput", has_energy, tpm.metric / joules_per_run, tpm.unit + "/J");
+    } else {
+      consumer.consumeResult("energy-efficiency-throughput", "N/A", "");
+    }
+  }
+
+private:
+  struct Domain {
+    enum { package, dram } kind;
+    std::filesystem::path energy_file;
+    std::uint64_t max_energy_uj = 0;
+    std::uint64_t before_uj = 0;
+    std::uint64_t total_uj = 0;
+    bool valid = true;
+  };
+
+  BenchmarkArgs args;
+  bool reads_node = false;
+  std::vector<Domain> domains;
+  // Summed over all nodes (master node only)
+  double package_j = 0.0, dram_j = 0.0;
+  bool has_package = false, has_dram = false;
+  std::size_t runs = 0;
+  std::chrono::steady_clock::time_point start;
+  std::chrono::steady_clock::duration elapsed{0};
+
+  static std::optional<std::uint64_t> readEnergy(const std::filesystem::path& file) {
+    std::uint64_t value;
+    std::ifstream in{file};
+    if(!(in >> value)) return std::nullopt;
+    return value;
+  }
+};
@@ -8,6 +8,10 @@
 #include <unordered_set>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <utility>
 
 class ResultConsumer
 {
@@ -131,5 +135,129 @@ private:
   std::ofstream output;
 };
 
+inline std::string jsonEscape(const std::string& s)
+{
+  std::string escaped;
+  for(char c : s) {
+    switch(c) {
+    case '"': escaped += "\\\""; break;
+    case '\\': escaped += "\\\\"; break;
+    case '\n': escaped += "\\n"; break;
+    case '\t': escaped += "\\t"; break;
+    case '\r': escaped += "\\r"; break;
+    default:
+      if(static_cast<unsigned char>(c) < 0x20) {
+        const char* hex = "0123456789abcdef";
+        escaped += std::string{"\\u00"} + hex[(c >> 4) & 0xf] + hex[c & 0xf];
+      } else {
+        escaped += c;
+      }
+    }
+  }
+  return "\"" + escaped + "\"";
+}
+
+// Appends one JSON object per benchmark to a file as soon as the benchmark has finished
+class JsonLinesResultConsumer : public ResultConsumer
+{
+public:
+  // metadata: key and already JSON-encoded value, written into every record
+  JsonLinesResultConsumer(const std::string& filename, std::vector<std::pair<std::string, std::string>> metadata)
+  : output{filename, std::ios::app}, metadata{std::move(metadata)}
+  {}
+
+  virtual void proceedToBenchmark(const std::string& benchmark_name) override
+  {
+    currentBenchmark = benchmark_name;
+    results.clear();
+  }
+
+  virtual void consumeResult(const std::string& result_name,
+                            const std::string& result,
+                            const std::string& unit = "") override
+  {
+    results.push_back({result_name, result, unit});
+  }
+
+  virtual void flush() override
+  {
+    // Only the master node emits results
+    if(results.empty()) return;
+
+    output << "{\"benchmark\":" << jsonEscape(currentBenchmark) << ",\"metadata\":{";
+    for(std::size_t i = 0; i < metadata.size(); ++i) {
+      output << (i == 0 ? "" : ",") << jsonEscape(metadata[i].first) << ":" << metadata[i].second;
+    }
+    output << "},\"results\":{";
+    for(std::size_t i = 0; i < results.size(); ++i) {
+      output << (i == 0 ? "" : ",") << jsonEscape(results[i].name) << ":{\"value\":" << toJsonValue(results[i].value);
+      if(!results[i].unit.empty()) {
+        output << ",\"unit\":" << jsonEscape(results[i].unit);
+      }
+      output << "}";
+    }
+    output << "}}" << std::endl;
+
+    results.clear();
+  }
+
+  void discard() override {
+    results.clear();
+  }
+
+private:
+  struct Result {
+    std::string name;
+    std::string value;
+    std::string unit;
+  };
+
+  std::ofstream output;
+  std::vector<std::pair<std::string, std::string>> metadata;
+  std::string currentBenchmark;
+  std::vector<Result> results;
+
+  // Whether s is a number in JSON syntax: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+  static bool isNumber(const std::string& s) {
+    std::size_t i = 0;
+    const auto digits = [&] {
+      const std::size_t begin = i;
+      while(i < s.size() && s[i] >= '0' && s[i] <= '9') ++i;
+      return i - begin;
+    };
+    if(i < s.size() && s[i] == '-') ++i;
+    if(i < s.size() && s[i] == '0') {
+      ++i;
+    } else if(digits() == 0) {
+      return false;
+    }
+    if(i < s.size() && s[i] == '.') {
+      ++i;
+      if(digits() == 0) return false;
+    }
+    if(i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+      ++i;
+      if(i < s.size() && (s[i] == '+' || s[i] == '-')) ++i;
+      if(digits() == 0) return false;
+    }
+    return i == s.size() && std::isfinite(std::strtod(s.c_str(), nullptr));
+  }
+
+  // Numbers become JSON numbers, N/A becomes null and quoted lists (such as samples) become arrays
+  static std::string toJsonValue(const std::string& value) {
+    if(value == "N/A") return "null";
+    if(isNumber(value)) return value;
+    if(value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+      std::stringstream istr(value.substr(1, value.size() - 2));
+      std::string element, array;
+      while(istr >> element) {
+        array += (array.empty() ? "" : ",") + (isNumber(element) ? element : jsonEscape(element));
+      }
+      return "[" + array + "]";
+    }
+    return jsonEscape(value);
+  }
+};
+
 #endif
 
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <iterator>
+#include <limits>
 #include <numeric>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <string>
@@ -10,6 +14,8 @@
 #include <unordered_set>
 #include <vector>
 
+#include <mpi.h>
+
 #include "benchmark_traits.h"
 #include "result_consumer.h"
 
@@ -28,6 +34,18 @@ struct ThroughputMetric {
   std::string unit = "";
 };
 
+/**
+ * Roofline metrics can be returned by benchmarks that implement the
+ * getRooflineMetric() function: the floating-point operations executed and the
+ * bytes moved by one run of the benchmark. The byte count is the compulsory
+ * traffic, i.e. every buffer element read or written by a kernel is counted once
+ * per kernel, so the attained bandwidth derived from it is a lower bound.
+ */
+struct RooflineMetric {
+  double flop = 0.0;
+  double bytes = 0.0;
+};
+
 template <typename Benchmark>
 class TimeMetricsProcessor {
 public:
@@ -40,6 +58,14 @@ public:
     timingResults[name].push_back(time);
   }
 
+  /**
+   * Adds the time this node alone took for a timing, i.e. measured before any
+   * barrier, from which gatherNodeResults() derives the load imbalance.
+   */
+  void addNodeTimingResult(const std::string& name, std::chrono::nanoseconds time) {
+    nodeTimingResults[name].push_back(time);
+  }
+
   /**
    * This is a bit of a hack that we need right now to ensure that all emitted results include the same
    * CSV columns, even if a timing is not available for a particular benchmark and/or SYCL implementation.
@@ -53,6 +79,71 @@ public:
     unavailableTimings.insert(name);
   }
 
+  // Returns the samples of an available timing in seconds, sorted ascending
+  std::vector<double> getSortedSeconds(const std::string& name) const {
+    std::vector<double> resultsSeconds;
+    std::transform(timingResults.at(name).begin(), timingResults.at(name).end(), std::back_inserter(resultsSeconds),
+        [](auto r) { return r.count() / 1.0e9; });
+    std::sort(resultsSeconds.begin(), resultsSeconds.end());
+    return resultsSeconds;
+  }
+
+  /**
+   * Returns the half-width of the 95% confidence interval of the median of the
+   * given timing, relative to the median. Returns an empty optional if there are
+   * not enough samples yet for the interval to be defined.
+   */
+  std::optional<double> getRelativeMedianCI(const std::string& name) const {
+    if(timingResults.count(name) == 0) return std::nullopt;
+
+    const auto resultsSeconds = getSortedSeconds(name);
+
+    const auto ci = getMedianCI(resultsSeconds);
+    if(!ci) return std::nullopt;
+    const double median = getPercentile(resultsSeconds, 50.0);
+    if(median <= 0.0) return std::nullopt;
+    return (ci->second - ci->first) / 2.0 / median;
+  }
+
+  /**
+   * Collective operation: Every node summarizes its own node timings (min, max,
+   * mean), see addNodeTimingResult(), and the summaries are gathered on the master
+   * node so that emitResults() can report the load imbalance across nodes.
+   * Must be called by all nodes, and all nodes must have recorded node timings
+   * under the same set of names, as the gathers are matched by name order.
+   */
+  void gatherNodeResults() {
+    int rank = 0;
+    int numNodes = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numNodes);
+
+    // Iterate in sorted order, as all nodes have to gather the timings in the same sequence
+    std::set<std::string> names;
+    for(const auto& [name, results] : nodeTimingResults) {
+      names.insert(name);
+    }
+
+    for(const auto& name : names) {
+      const auto& results = nodeTimingResults.at(name);
+      NodeSummary local;
+      local.min = std::numeric_limits<double>::max();
+      for(const auto r : results) {
+        const double seconds = r.count() / 1.0e9;
+        local.min = std::min(local.min, seconds);
+        local.max = std::max(local.max, seconds);
+        local.mean += seconds;
+      }
+      local.mean /= static_cast<double>(results.size());
+
+      std::vector<NodeSummary> gathered(rank == 0 ? numNodes : 0);
+      MPI_Gather(&local, 3, MPI_DOUBLE, gathered.data(), 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+      if(rank == 0) {
+        nodeResults[name] = std::move(gathered);
+      }
+    }
+  }
+
   void emitResults(ResultConsumer& consumer) const {
     // Begin by outputting the throughput metric (if available), as this does not depend on a timing.
     if constexpr(cl::sycl::detail::BenchmarkTraits<Benchmark>::hasGetThroughputMetric) {
@@ -62,6 +153,17 @@ public:
       consumer.consumeResult("throughput-metric", "N/A", "");
     }
 
+    if constexpr(cl::sycl::detail::BenchmarkTraits<Benchmark>::hasGetRooflineMetric) {
+      const auto rm = Benchmark::getRooflineMetric(args);
+      consumer.consumeResult("flop", std::to_string(rm.flop), "FLOP");
+      consumer.consumeResult("bytes", std::to_string(rm.bytes), "B");
+      consumer.consumeResult("arithmetic-intensity", std::to_string(rm.flop / rm.bytes), "FLOP/B");
+    } else {
+      consumer.consumeResult("flop", "N/A", "");
+      consumer.consumeResult("bytes", "N/A", "");
+      consumer.consumeResult("arithmetic-intensity", "N/A", "");
+    }
+
     // We have to ensure that available and unavailable timings are always being emitted in the same order.
     // To this end, we copy all timing names into a sorted container and iterate over it afterwards.
     std::set<std::string> allTimings;
@@ -74,31 +176,65 @@ public:
 
     for(const auto& name : allTimings) {
       if(unavailableTimings.count(name) == 0) {
-        std::vector<double> resultsSeconds;
-        std::transform(timingResults.at(name).begin(), timingResults.at(name).end(), std::back_inserter(resultsSeconds),
-            [](auto r) { return r.count() / 1.0e9; });
-        std::sort(resultsSeconds.begin(), resultsSeconds.end());
+        const auto resultsSeconds = getSortedSeconds(name);
 
-        double mean = std::accumulate(resultsSeconds.begin(), resultsSeconds.end(), 0.0) /
-                      static_cast<double>(resultsSeconds.size());
+        // Tukey's fences: samples further than 1.5 IQR outside the quartiles are outliers
+        const double p25 = getPercentile(resultsSeconds, 25.0);
+        const double p75 = getPercentile(resultsSeconds, 75.0);
+        const double iqr = p75 - p25;
+        const double lowerFence = p25 - 1.5 * iqr;
+        const double upperFence = p75 + 1.5 * iqr;
+        const auto isOutlier = [&](double x) { return x < lowerFence || x > upperFence; };
+        const auto numOutliers = std::count_if(resultsSeconds.begin(), resultsSeconds.end(), isOutlier);
+
+        // With --exclude-outliers, mean and stddev are computed over the remaining samples only
+        std::vector<double> meanSamples;
+        std::copy_if(resultsSeconds.begin(), resultsSeconds.end(), std::back_inserter(meanSamples),
+            [&](double x) { return !args.cli.isFlagSet("--exclude-outliers") || !isOutlier(x); });
+
+        double mean = std::accumulate(meanSamples.begin(), meanSamples.end(), 0.0) /
+                      static_cast<double>(meanSamples.size());
 
         double stddev = 0.0;
-        for(double x : resultsSeconds) {
+        for(double x : meanSamples) {
           double dev = mean - x;
           stddev += dev * dev;
         }
-        if(resultsSeconds.size() <= 1) {
+        if(meanSamples.size() <= 1) {
           stddev = 0.0;
         } else {
-          stddev /= static_cast<double>(resultsSeconds.size() - 1);
+          stddev /= static_cast<double>(meanSamples.size() - 1);
           stddev = std::sqrt(stddev);
         }
 
-        const double median = resultsSeconds[resultsSeconds.size() / 2];
+        const double median = getPercentile(resultsSeconds, 50.0);
+
+        std::vector<double> absDeviations;
+        std::transform(resultsSeconds.begin(), resultsSeconds.end(), std::back_inserter(absDeviations),
+            [&](double x) { return std::abs(x - median); });
+        std::sort(absDeviations.begin(), absDeviations.end());
+        const double mad = getPercentile(absDeviations, 50.0);
 
         consumer.consumeResult(name + "-mean", std::to_string(mean), "s");
         consumer.consumeResult(name + "-stddev", std::to_string(stddev), "s");
         consumer.consumeResult(name + "-median", std::to_string(median), "s");
+        consumer.consumeResult(name + "-p5", std::to_string(getPercentile(resultsSeconds, 5.0)), "s");
+        consumer.consumeResult(name + "-p25", std::to_string(p25), "s");
+        consumer.consumeResult(name + "-p75", std::to_string(p75), "s");
+        consumer.consumeResult(name + "-p95", std::to_string(getPercentile(resultsSeconds, 95.0)), "s");
+        consumer.consumeResult(name + "-p99", std::to_string(getPercentile(resultsSeconds, 99.0)), "s");
+        consumer.consumeResult(name + "-mad", std::to_string(mad), "s");
+        consumer.consumeResult(name + "-iqr", std::to_string(iqr), "s");
+        consumer.consumeResult(name + "-outliers", std::to_string(numOutliers));
+        if(const auto ci = getMedianCI(resultsSeconds); ci && median > 0.0) {
+          consumer.consumeResult(name + "-median-ci-low", std::to_string(ci->first), "s");
+          consumer.consumeResult(name + "-median-ci-high", std::to_string(ci->second), "s");
+          consumer.consumeResult(name + "-rel-ci", std::to_string((ci->second - ci->first) / 2.0 / median));
+        } else {
+          consumer.consumeResult(name + "-median-ci-low", "N/A");
+          consumer.consumeResult(name + "-median-ci-high", "N/A");
+          consumer.consumeResult(name + "-rel-ci", "N/A");
+        }
         consumer.consumeResult(name + "-min", std::to_string(resultsSeconds[0]), "s");
 
         // Emit individual samples as well
@@ -128,21 +264,127 @@ public:
         } else {
           consumer.consumeResult(name + "-throughput", "N/A", "");
         }
+
+        // Like the throughput, the attained rates are based on the fastest run
+        if constexpr(cl::sycl::detail::BenchmarkTraits<Benchmark>::hasGetRooflineMetric) {
+          const double min = resultsSeconds[0];
+          const auto rm = Benchmark::getRooflineMetric(args);
+          consumer.consumeResult(name + "-gflops", std::to_string(rm.flop / min / 1.0e9), "GFLOP/s");
+          consumer.consumeResult(name + "-gbps", std::to_string(rm.bytes / min / 1.0e9), "GB/s");
+        } else {
+          consumer.consumeResult(name + "-gflops", "N/A", "");
+          consumer.consumeResult(name + "-gbps", "N/A", "");
+        }
+
+        emitNodeResults(consumer, name);
       } else {
         // Now the hacky part: Emit columns also for unavailable timings.
         // FIXME: Come up with a cleaner solution.
         consumer.consumeResult(name + "-mean", "N/A");
         consumer.consumeResult(name + "-stddev", "N/A");
         consumer.consumeResult(name + "-median", "N/A");
+        consumer.consumeResult(name + "-p5", "N/A");
+        consumer.consumeResult(name + "-p25", "N/A");
+        consumer.consumeResult(name + "-p75", "N/A");
+        consumer.consumeResult(name + "-p95", "N/A");
+        consumer.consumeResult(name + "-p99", "N/A");
+        consumer.consumeResult(name + "-mad", "N/A");
+        consumer.consumeResult(name + "-iqr", "N/A");
+        consumer.consumeResult(name + "-outliers", "N/A");
+        consumer.consumeResult(name + "-median-ci-low", "N/A");
+        consumer.consumeResult(name + "-median-ci-high", "N/A");
+        consumer.consumeResult(name + "-rel-ci", "N/A");
         consumer.consumeResult(name + "-min", "N/A");
         consumer.consumeResult(name + "-samples", "N/A");
         consumer.consumeResult(name + "-throughput", "N/A");
+        consumer.consumeResult(name + "-gflops", "N/A");
+        consumer.consumeResult(name + "-gbps", "N/A");
+        emitNodeResults(consumer, name);
       }
     }
   }
 
 private:
+  struct NodeSummary {
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+  };
+
+  /**
+   * Per-node min/max/mean are emitted as space-separated lists ordered by node id.
+   * The imbalance factor is the slowest node's mean divided by the mean over all nodes.
+   */
+  void emitNodeResults(ResultConsumer& consumer, const std::string& name) const {
+    if(nodeResults.count(name) == 0) {
+      consumer.consumeResult(name + "-node-min", "N/A");
+      consumer.consumeResult(name + "-node-max", "N/A");
+      consumer.consumeResult(name + "-node-mean", "N/A");
+      consumer.consumeResult(name + "-imbalance", "N/A");
+      consumer.consumeResult(name + "-slowest-node", "N/A");
+      return;
+    }
+
+    const auto& nodes = nodeResults.at(name);
+    std::stringstream mins, maxs, means;
+    mins << "\"";
+    maxs << "\"";
+    means << "\"";
+    std::size_t slowest = 0;
+    double sumOfMeans = 0.0;
+    for(std::size_t i = 0; i < nodes.size(); ++i) {
+      const char* sep = i != nodes.size() - 1 ? " " : "";
+      mins << std::to_string(nodes[i].min) << sep;
+      maxs << std::to_string(nodes[i].max) << sep;
+      means << std::to_string(nodes[i].mean) << sep;
+      sumOfMeans += nodes[i].mean;
+      if(nodes[i].mean > nodes[slowest].mean) slowest = i;
+    }
+    mins << "\"";
+    maxs << "\"";
+    means << "\"";
+
+    const double meanOfMeans = sumOfMeans / static_cast<double>(nodes.size());
+    consumer.consumeResult(name + "-node-min", mins.str(), "s");
+    consumer.consumeResult(name + "-node-max", maxs.str(), "s");
+    consumer.consumeResult(name + "-node-mean", means.str(), "s");
+    consumer.consumeResult(name + "-imbalance", meanOfMeans > 0.0 ? std::to_string(nodes[slowest].mean / meanOfMeans) : "N/A");
+    consumer.consumeResult(name + "-slowest-node", std::to_string(slowest));
+  }
+
+public:
+  /**
+   * Percentile p (0..100) of sorted samples, linearly interpolating between the
+   * closest ranks. For p = 50 this is the median, also for even sample counts.
+   */
+  static double getPercentile(const std::vector<double>& sorted, double p) {
+    if(sorted.empty()) return 0.0;
+    const double rank = p / 100.0 * static_cast<double>(sorted.size() - 1);
+    const std::size_t lo = static_cast<std::size_t>(std::floor(rank));
+    const std::size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (rank - static_cast<double>(lo)) * (sorted[hi] - sorted[lo]);
+  }
+
+private:
+
+  /**
+   * Distribution-free 95% confidence interval of the median, using the order
+   * statistics at ranks n/2 -+ 1.96*sqrt(n)/2. Needs at least 8 sorted samples.
+   */
+  static std::optional<std::pair<double, double>> getMedianCI(const std::vector<double>& sorted) {
+    const double n = static_cast<double>(sorted.size());
+    const double halfWidth = 1.96 * std::sqrt(n) / 2.0;
+    // 1-based ranks of the lower and upper bound
+    const long lo = static_cast<long>(std::floor(n / 2.0 - halfWidth));
+    const long hi = static_cast<long>(std::ceil(1.0 + n / 2.0 + halfWidth));
+    if(lo < 1 || hi > static_cast<long>(sorted.size())) return std::nullopt;
+    return std::make_pair(sorted[lo - 1], sorted[hi - 1]);
+  }
+
   const BenchmarkArgs args;
   std::unordered_map<std::string, std::vector<std::chrono::nanoseconds>> timingResults;
+  std::unordered_map<std::string, std::vector<std::chrono::nanoseconds>> nodeTimingResults;
   std::unordered_set<std::string> unavailableTimings;
+  // only populated on the master node, see gatherNodeResults()
+  std::unordered_map<std::string, std::vector<NodeSummary>> nodeResults;
 };
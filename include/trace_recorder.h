@@ -0,0 +1,123 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <mpi.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "result_consumer.h"
+
+/**
+ * Records the phases of the benchmark harness as Chrome trace events
+ * (chrome://tracing, ui.perfetto.dev) when --trace=<file> is given.
+ *
+ * Every rank records its own events, using its rank as pid and the recording
+ * thread as tid. Timestamps are relative to a barrier at enable(), so ranks are
+ * aligned up to the barrier's skew. write() is collective and gathers all events
+ * on the master node, which writes the file.
+ */
+class TraceRecorder
+{
+public:
+  static TraceRecorder& getInstance() {
+    static TraceRecorder inst;
+    return inst;
+  }
+
+  // Records an event covering the lifetime of the scope
+  class Scope
+  {
+  public:
+    Scope(const std::string& name, const std::string& category)
+        : name(name), category(category), begin(std::chrono::high_resolution_clock::now()) {}
+    ~Scope() { TraceRecorder::getInstance().addEvent(name, category, begin, std::chrono::high_resolution_clock::now()); }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    std::string name;
+    std::string category;
+    std::chrono::high_resolution_clock::time_point begin;
+  };
+
+  void enable() {
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Barrier(MPI_COMM_WORLD);
+    epoch = std::chrono::high_resolution_clock::now();
+    enabled = true;
+  }
+
+  bool isEnabled() const { return enabled; }
+
+  void addEvent(const std::string& name, const std::string& category, std::chrono::high_resolution_clock::time_point begin,
+      std::chrono::high_resolution_clock::time_point end) {
+    if(!enabled) return;
+    const auto us = [](auto d) { return std::chrono::duration<double, std::micro>(d).count(); };
+    std::ostringstream event;
+    event << "{\"name\":" << jsonEscape(name) << ",\"cat\":" << jsonEscape(category) << ",\"ph\":\"X\",\"ts\":" << std::fixed
+          << us(begin - epoch) << ",\"dur\":" << us(end - begin) << ",\"pid\":" << rank
+          << ",\"tid\":" << static_cast<long>(syscall(SYS_gettid)) << "}";
+    events.push_back(event.str());
+  }
+
+  void write(const std::string& path) {
+    if(!enabled) return;
+
+    std::string local = "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + std::to_string(rank) +
+                        ",\"args\":{\"name\":\"rank " + std::to_string(rank) + "\"}}";
+    for(const auto& e : events) {
+      local += ",\n" + e;
+    }
+
+    int num_ranks = 0;
+    MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+    const int local_size = static_cast<int>(local.size());
+    std::vector<int> sizes(rank == 0 ? num_ranks : 0);
+    MPI_Gather(&local_size, 1, MPI_INT, sizes.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    std::vector<int> offsets(sizes.size());
+    std::string all;
+    if(rank == 0) {
+      int total = 0;
+      for(std::size_t i = 0; i < sizes.size(); ++i) {
+        offsets[i] = total;
+        total += sizes[i];
+      }
+      all.resize(total);
+    }
+    MPI_Gatherv(local.data(), local_size, MPI_CHAR, all.data(), sizes.data(), offsets.data(), MPI_CHAR, 0,
+        MPI_COMM_WORLD);
+
+    if(rank == 0) {
+      std::ofstream out{path};
+      out << "{\"traceEvents\":[\n";
+      for(std::size_t i = 0; i < sizes.size(); ++i) {
+        if(i != 0) out << ",\n";
+        out << all.substr(offsets[i], sizes[i]);
+      }
+      out << "\n]}\n";
+      if(!out) {
+        std::cerr << "Could not write trace to " << path << std::endl;
+      }
+    }
+    events.clear();
+  }
+
+  TraceRecorder(TraceRecorder const&) = delete;
+  void operator=(TraceRecorder const&) = delete;
+
+private:
+  TraceRecorder() {}
+
+  bool enabled = false;
+  int rank = 0;
+  std::chrono::high_resolution_clock::time_point epoch;
+  std::vector<std::string> events;
+};
@@ -8,7 +8,7 @@ struct ReadableTypename
 #define MAKE_READABLE_TYPENAME(T, str) \
 template<> \
 struct ReadableTypename<T> \
-{ static const char* name; }; const char* ReadableTypename<T>::name = str;
+{ static inline const char* name = str; static inline const char* cpp_name = #T; };
 
 MAKE_READABLE_TYPENAME(char, "int8")
 MAKE_READABLE_TYPENAME(unsigned char, "uint8")
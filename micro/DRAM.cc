@@ -2,45 +2,49 @@
 
 namespace s = cl::sycl;
 
+template <typename T, int Dims>
 class MicroBenchDRAMKernel;
 
 class CopyBufferDummyKernel;
 
-s::range<BENCH_DIMS> getBufferSize(size_t problemSize) {
-#if BENCH_DIMS == 1
-  return s::range<1>(problemSize);
-#elif BENCH_DIMS == 2
-  return s::range<2>(problemSize, problemSize);
-#elif BENCH_DIMS == 3
-  return s::range<3>(problemSize, problemSize, problemSize);
-#endif
+template <int Dims>
+s::range<Dims> getBufferSize(size_t problemSize) {
+  if constexpr(Dims == 1) {
+    return s::range<1>(problemSize);
+  } else if constexpr(Dims == 2) {
+    return s::range<2>(problemSize, problemSize);
+  } else {
+    return s::range<3>(problemSize, problemSize, problemSize);
+  }
 }
 
 /**
  * Microbenchmark measuring DRAM bandwidth.
  */
+template <typename T, int Dims>
 class MicroBenchDRAM {
 protected:
   BenchmarkArgs args;
-  const s::range<BENCH_DIMS> buffer_size;
+  const s::range<Dims> buffer_size;
   // Since we cannot use explicit memory operations to initialize the input buffer,
   // we have to keep this around, unfortunately.
-  std::vector<BENCH_DATA_TYPE> input;
-  PrefetchedBuffer<BENCH_DATA_TYPE, BENCH_DIMS> input_buf;
-  PrefetchedBuffer<BENCH_DATA_TYPE, BENCH_DIMS> output_buf;
+  std::vector<T> input;
+  PrefetchedBuffer<T, Dims> input_buf;
+  PrefetchedBuffer<T, Dims> output_buf;
 
 public:
   MicroBenchDRAM(const BenchmarkArgs& args)
-      : args(args), buffer_size(getBufferSize(args.problem_size)), input(buffer_size.size(), 33.f) {}
+      : args(args), buffer_size(getBufferSize<Dims>(args.problem_size)) {}
 
   void setup() {
+    input.resize(buffer_size.size(), T{33});
     input_buf.initialize(input.data(), buffer_size);
     output_buf.initialize(buffer_size);
   }
 
   static ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) {
     const double copiedGiB =
-        getBufferSize(args.problem_size).size() * sizeof(BENCH_DATA_TYPE) / 1024.0 / 1024.0 / 1024.0;
+        getBufferSize<Dims>(args.problem_size).size() * sizeof(T) / 1024.0 / 1024.0 / 1024.0;
     // Multiply by two as we are both reading and writing one element in each thread.
     return {copiedGiB * 2.0, "GiB"};
   }
@@ -48,68 +52,38 @@ public:
   void run() {
     celerity::distr_queue& queue = QueueManager::getInstance();
 
-    celerity::buffer<BENCH_DATA_TYPE, BENCH_DIMS>& a = input_buf.get();
-    celerity::buffer<BENCH_DATA_TYPE, BENCH_DIMS>& b = output_buf.get();
+    celerity::buffer<T, Dims>& a = input_buf.get();
+    celerity::buffer<T, Dims>& b = output_buf.get();
 
     queue.submit([=](celerity::handler& cgh) {
-      auto in = a.template get_access<s::access::mode::read>(cgh, celerity::access::one_to_one<BENCH_DIMS>());
-      auto out = b.template get_access<s::access::mode::discard_write>(cgh, celerity::access::one_to_one<BENCH_DIMS>());
+      auto in = a.template get_access<s::access::mode::read>(cgh, celerity::access::one_to_one<Dims>());
+      auto out = b.template get_access<s::access::mode::discard_write>(cgh, celerity::access::one_to_one<Dims>());
       // We spawn one work item for each buffer element to be copied.
-      const s::range<BENCH_DIMS> global_size{buffer_size};
-      cgh.parallel_for<MicroBenchDRAMKernel>(global_size, [=](s::id<BENCH_DIMS> gid) { out[gid] = in[gid]; });
+      const s::range<Dims> global_size{buffer_size};
+      cgh.parallel_for<MicroBenchDRAMKernel<T, Dims>>(global_size, [=](s::id<Dims> gid) { out[gid] = in[gid]; });
     });
   }
 
   bool verify(VerificationSetting& ver) {
-    bool pass = true;
-    QueueManager::getInstance().with_master_access([&](celerity::handler& cgh) {
-      auto result = output_buf.template get_access<s::access::mode::read>(cgh, s::range<BENCH_DIMS>(buffer_size));
-      cgh.run([=,&pass]() {
-        for(size_t i = 0; i < buffer_size[0]; ++i) {
-          for(size_t j = 0; j < (BENCH_DIMS < 2 ? 1 : buffer_size[1]); ++j) {
-            for(size_t k = 0; k < (BENCH_DIMS < 3 ? 1 : buffer_size[2]); ++k) {
-#if BENCH_DIMS == 1
-              if(result[i] != 33.f) {
-                pass = false;
-                break;
-              }
-#elif BENCH_DIMS == 2
-              if(result[{i, j}] != 33.f) {
-                pass = false;
-                break;
-              }
-#elif BENCH_DIMS == 3
-              if(result[{i, j, k}] != 33.f) {
-                pass = false;
-                break;
-              }
-#endif
-            }
-            if(!pass)
-              break;
-          }
-          if(!pass)
-            break;
-        }
-      });
-    });
-    QueueManager::sync();
-    return pass;
+    return verifyPartitions(QueueManager::getInstance(), output_buf.get(), ver, generators::Constant<T>{T{33}});
   }
 
+  static std::size_t getNumElements(const BenchmarkArgs& args) { return getBufferSize<Dims>(args.problem_size).size(); }
+
   static std::string getBenchmarkName() {
     std::stringstream name;
     name << "MicroBench_DRAM_";
-    name << ReadableTypename<BENCH_DATA_TYPE>::name;
-    name << "_" << BENCH_DIMS;
+    name << ReadableTypename<T>::name;
+    name << "_" << Dims;
     return name.str();
   }
 };
 
-int main(int argc, char** argv) {
-  BenchmarkApp app(argc, argv);
-
-  app.run<MicroBenchDRAM>();
-
-  return 0;
+BENCHMARK_MAIN(DRAM, app) {
+  forEachVariant(TypeList<float, double>{}, ValueList<1, 2, 3>{}, [&](auto type, auto dims) {
+    using T = typename decltype(type)::type;
+    if(app.shouldRunType<T>() && app.shouldRunDims(dims)) {
+      app.run<MicroBenchDRAM<T, decltype(dims)::value>>();
+    }
+  });
 }
@@ -4,17 +4,19 @@
 
 namespace s = cl::sycl;
 
+template <typename T, int Iterations>
 class MicroBenchL2Kernel;
 
 /* Microbenchmark stressing the main arithmetic units. */
+template <typename T, int Iterations>
 class MicroBenchL2
 {
 protected:
-    std::vector<BENCH_DATA_TYPE> input;
+    std::vector<T> input;
     BenchmarkArgs args;
 
-    PrefetchedBuffer<BENCH_DATA_TYPE, 1> input_buf;
-    PrefetchedBuffer<BENCH_DATA_TYPE, 1> output_buf;
+    PrefetchedBuffer<T, 1> input_buf;
+    PrefetchedBuffer<T, 1> output_buf;
 public:
   MicroBenchL2(const BenchmarkArgs &_args) : args(_args) {}
 
@@ -29,19 +31,19 @@ public:
   void run(){
     celerity::distr_queue& queue = QueueManager::getInstance();
 
-    celerity::buffer<BENCH_DATA_TYPE, 1>& a = input_buf.get();
-    celerity::buffer<BENCH_DATA_TYPE, 1>& b = output_buf.get();
+    celerity::buffer<T, 1>& a = input_buf.get();
+    celerity::buffer<T, 1>& b = output_buf.get();
 
     queue.submit([=](celerity::handler& cgh) {
       auto in  = a.template get_access<s::access::mode::read>(cgh, celerity::access::one_to_one<1>());
       auto out = b.template get_access<s::access::mode::discard_write>(cgh, celerity::access::one_to_one<1>());
       cl::sycl::range<1> ndrange {args.problem_size};
 
-      cgh.parallel_for<MicroBenchL2Kernel>(ndrange,
+      cgh.parallel_for<MicroBenchL2Kernel<T, Iterations>>(ndrange,
         [=](cl::sycl::id<1> gid)
       {
-        BENCH_DATA_TYPE r0;
-        for (int i=0;i<BENCH_COMP_ITERS;i++) {
+        T r0;
+        for (int i=0;i<Iterations;i++) {
             r0 = in[gid];
             out[gid] = r0; 
         }
@@ -53,20 +55,17 @@ public:
   static std::string getBenchmarkName() {
     std::stringstream name;
     name << "MicroBench_L2_";
-    name << ReadableTypename<BENCH_DATA_TYPE>::name << "_";
-    name << BENCH_COMP_ITERS;
+    name << ReadableTypename<T>::name << "_";
+    name << Iterations;
     return name.str();
   }
 };
 
-int main(int argc, char** argv)
-{
-  BenchmarkApp app(argc, argv);
-
-  app.run< MicroBenchL2 >();
-
-  return 0;
+BENCHMARK_MAIN(L2, app) {
+  forEachVariant(TypeList<int, float, double>{}, ValueList<1, 2, 4, 8, 16>{}, [&](auto type, auto iters) {
+    using T = typename decltype(type)::type;
+    if(app.shouldRunType<T>() && app.shouldRunIterations(iters)) {
+      app.run<MicroBenchL2<T, decltype(iters)::value>>();
+    }
+  });
 }
-
-
-
@@ -15,20 +15,13 @@ class MultipleBuffersBench
 protected:    
   BenchmarkArgs args;
 
-  std::vector<BENCH_DATA_TYPE> input1;
-  std::vector<BENCH_DATA_TYPE> input2;
-  std::vector<BENCH_DATA_TYPE> output;
   PrefetchedBuffer<BENCH_DATA_TYPE, 2> input1_buf;
   PrefetchedBuffer<BENCH_DATA_TYPE, 2> input2_buf;
   PrefetchedBuffer<BENCH_DATA_TYPE, 2> output_buf;
 #if BENCH_BUFFERS >= 4
-  std::vector<BENCH_DATA_TYPE> input3;
-  std::vector<BENCH_DATA_TYPE> input4;
   PrefetchedBuffer<BENCH_DATA_TYPE, 2> input3_buf;
   PrefetchedBuffer<BENCH_DATA_TYPE, 2> input4_buf;
 #if BENCH_BUFFERS == 6
-  std::vector<BENCH_DATA_TYPE> input5;
-  std::vector<BENCH_DATA_TYPE> input6;    
   PrefetchedBuffer<BENCH_DATA_TYPE, 2> input5_buf;
   PrefetchedBuffer<BENCH_DATA_TYPE, 2> input6_buf;
 #endif
@@ -38,42 +31,17 @@ public:
   MultipleBuffersBench(const BenchmarkArgs &_args) : args(_args) {}
   
   void setup() {
-    // host memory intilization
-    input1.resize(args.problem_size*args.problem_size);
-    input2.resize(args.problem_size*args.problem_size);
-    output.resize(args.problem_size*args.problem_size);
+    const auto range = s::range<2>(args.problem_size, args.problem_size);
+    const auto index = generators::Iota<BENCH_DATA_TYPE>{args.problem_size};
+    input1_buf.initialize(range, index);
+    input2_buf.initialize(range, index);
+    output_buf.initialize(range, generators::Constant<BENCH_DATA_TYPE>{0});
 #if BENCH_BUFFERS >= 4
-    input3.resize(args.problem_size*args.problem_size);
-    input4.resize(args.problem_size*args.problem_size);
+    input3_buf.initialize(range, index);
+    input4_buf.initialize(range, index);
 #if BENCH_BUFFERS == 6
-    input5.resize(args.problem_size*args.problem_size);
-    input6.resize(args.problem_size*args.problem_size);
-#endif
-#endif
-
-    for (size_t i = 0; i < args.problem_size*args.problem_size; i++) {
-      input1[i] = static_cast<BENCH_DATA_TYPE>(i);
-      input2[i] = static_cast<BENCH_DATA_TYPE>(i);
-      output[i] = static_cast<BENCH_DATA_TYPE>(0);
-#if BENCH_BUFFERS >= 4
-      input3[i] = static_cast<BENCH_DATA_TYPE>(i);
-      input4[i] = static_cast<BENCH_DATA_TYPE>(i);
-#if BENCH_BUFFERS == 6
-      input5[i] = static_cast<BENCH_DATA_TYPE>(i);
-      input6[i] = static_cast<BENCH_DATA_TYPE>(i);            
-#endif
-#endif
-    }
-
-    input1_buf.initialize(input1.data(), s::range<2>(args.problem_size, args.problem_size));
-    input2_buf.initialize(input2.data(), s::range<2>(args.problem_size, args.problem_size));
-    output_buf.initialize(output.data(), s::range<2>(args.problem_size, args.problem_size));
-#if BENCH_BUFFERS >= 4
-    input3_buf.initialize(input3.data(), s::range<2>(args.problem_size, args.problem_size));
-    input4_buf.initialize(input4.data(), s::range<2>(args.problem_size, args.problem_size));
-#if BENCH_BUFFERS == 6
-    input5_buf.initialize(input5.data(), s::range<2>(args.problem_size, args.problem_size));
-    input6_buf.initialize(input6.data(), s::range<2>(args.problem_size, args.problem_size)); 
+    input5_buf.initialize(range, index);
+    input6_buf.initialize(range, index);
 #endif
 #endif
   }
@@ -203,32 +171,18 @@ public:
   }
 
   bool verify(VerificationSetting &ver) {
-    bool verification_passed = true;
-    QueueManager::getInstance().with_master_access([&](celerity::handler& cgh) {
-      auto result = output_buf.template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<2>(args.problem_size, args.problem_size));
-      cgh.run([=, &verification_passed]() {
-        for(size_t i = 0; i < args.problem_size; i++){
-          for (size_t j = 0; j < args.problem_size; j++) {
-            auto expected = input1[i*args.problem_size + j] + input2[i*args.problem_size + j]
-#if BENCH_BUFFERS >= 4
-                            +input3[i*args.problem_size + j] + input4[i*args.problem_size + j]
-#if BENCH_BUFFERS == 6
-                            +input5[i*args.problem_size + j] + input6[i*args.problem_size + j]
-#endif
-#endif
-                            ;
-            if(expected != result[i][j]){
-                verification_passed = false;
-                break;
-            }
-          } 
-        } 
-      });
+    // Every input holds the linear index of its elements
+    const auto index = generators::Iota<BENCH_DATA_TYPE>{args.problem_size};
+    return verifyPartitions(QueueManager::getInstance(), output_buf.get(), ver, [=](size_t i, size_t j) {
+      // Summed in the order of the kernels so floating point results match exactly
+      BENCH_DATA_TYPE expected = index(i, j);
+      for(int b = 1; b < BENCH_BUFFERS; ++b) expected += index(i, j);
+      return expected;
     });
-    QueueManager::sync();
-    return verification_passed;
-  }  
+  }
   
+  static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
   static std::string getBenchmarkName() {
     std::stringstream name;
     name << "MultipleBuffers_";
@@ -237,10 +191,6 @@ public:
   }
 };
 
-int main(int argc, char** argv)
-{
-  BenchmarkApp app(argc, argv);
-  
+BENCHMARK_MAIN(multiple_buffers, app) {
   app.run<MultipleBuffersBench>();
-  return 0;
 }
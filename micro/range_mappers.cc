@@ -168,6 +168,8 @@ public:
     return verification_passed;
   }  
   
+  static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
   static std::string getBenchmarkName() {
     std::stringstream name;
     name << "RangeMappers_";
@@ -176,12 +178,9 @@ public:
   }
 };
 
-int main(int argc, char** argv)
-{
-  BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(range_mappers, app) {
   size_t neigh_size_limit = 16;
   size_t fixed_size_limit = 4;
 
   app.run<RangeMappersBench>(neigh_size_limit, fixed_size_limit);
-  return 0;
 }
@@ -416,6 +416,8 @@ public:
     return verification_passed;
   }  
   
+  static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
   static std::string getBenchmarkName() {
     std::stringstream name;
     name << "RangeMappers_";
@@ -424,9 +426,6 @@ public:
   }
 };
 
-int main(int argc, char** argv)
-{
-  BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(sequential_range_mappers, app) {
   app.run<RangeMappersBench>();
-  return 0;
 }
@@ -11,6 +11,8 @@ void conv2D(celerity::distr_queue queue,
                celerity::buffer<BENCH_DATA_TYPE, 2> mat_a,
                celerity::buffer<BENCH_DATA_TYPE, 2> mat_b,
                const size_t mat_size){
+    // No inner points to compute
+    if(mat_size <= 2) return;
     queue.submit([=](celerity::handler& cgh) {
         celerity::accessor A{mat_a, cgh, celerity::access::neighborhood<2>(1,1), celerity::read_only};
         celerity::accessor B{mat_b, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
@@ -18,8 +20,9 @@ void conv2D(celerity::distr_queue queue,
             const BENCH_DATA_TYPE c11 = +0.2, c21 = +0.5, c31 = -0.8;
             const BENCH_DATA_TYPE c12 = -0.3, c22 = +0.6, c32 = -0.9;
             const BENCH_DATA_TYPE c13 = +0.4, c23 = +0.7, c33 = +0.10;
-            const auto i = item[0] + 1;
-            const auto j = item[1] + 1;
+            // The item already includes the offset of {1, 1}
+            const auto i = item[0];
+            const auto j = item[1];
 
             B[item] = c11 * A[{(i - 1), (j - 1)}] + c12 * A[{(i + 0), (j - 1)}] + c13 * A[{(i + 1), (j - 1)}]
                     + c21 * A[{(i - 1), (j + 0)}] + c22 * A[{(i + 0), (j + 0)}] + c23 * A[{(i + 1), (j + 0)}]
@@ -30,8 +33,6 @@ void conv2D(celerity::distr_queue queue,
 
 class Conv2D {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_b;
     BenchmarkArgs args;
     int mat_size;
 
@@ -44,19 +45,8 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_b = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-
-        // random seed
-        srand(42);
-        for(size_t i = 0; i < mat_size; ++i) {
-            for(size_t j = 0; j < mat_size; ++j) {
-                mat_a[i * mat_size + j] = (BENCH_DATA_TYPE)rand() / RAND_MAX;
-            }
-        }
-
         auto range = celerity::range<2>(mat_size, mat_size);
-        mat_a_buf.initialize(mat_a.data(), range);
+        mat_a_buf.initialize(range, args.getInputFile(0), generators::Random<BENCH_DATA_TYPE>{args.seed});
         mat_b_buf.initialize(range);
     }
 
@@ -64,37 +54,40 @@ public:
         conv2D(QueueManager::getInstance(), mat_a_buf.get(), mat_b_buf.get(), mat_size);
     }
 
-    static std::string getBenchmarkName() { return "Conv2D"; }
+    static RooflineMetric getRooflineMetric(const BenchmarkArgs& args) {
+        const double n = args.problem_size;
+        const double inner = n > 2 ? n - 2 : 0;
+        const double points = inner * inner;
+        // 9 multiplies and 8 adds per inner point; reads A, writes the inner points of B
+        return {17.0 * points, (n * n + points) * sizeof(BENCH_DATA_TYPE)};
+    }
 
-    bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        /* QueueManager::getInstance().with_master_access([&](celerity::handler& cgh) {
-            auto result = mat_b_buf.template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<2>(mat_size, mat_size));
-            cgh.run([=, &verification_passed]() {
-                for(size_t i = 1; i < mat_size -1 && verification_passed; ++i)
-                    for(size_t j = 1; j < mat_size -1 && verification_passed; ++j){
-                        const BENCH_DATA_TYPE c11 = +0.2, c21 = +0.5, c31 = -0.8;
-                        const BENCH_DATA_TYPE c12 = -0.3, c22 = +0.6, c32 = -0.9;
-                        const BENCH_DATA_TYPE c13 = +0.4, c23 = +0.7, c33 = +0.10;
-                        if((i < mat_size - 1) && (j < mat_size - 1) && (i > 0) && (j > 0)){
-                            auto res = (c11 * mat_a[(((i- 1)*mat_size))+(j - 1)] + c12 * mat_a[((i*mat_size) + 0)+(j - 1)] + c13 * mat_a[(((i+1)*mat_size) )+(j - 1)] + c21 * mat_a[(((i- 1)*mat_size) )+(j + 0)]
-                                        + c22 * mat_a[((i*mat_size) + 0)+(j + 0)] + c23 * mat_a[(((i+ 1)*mat_size) )+(j + 0)] + c31 * mat_a[(((i- 1)*mat_size) )+(j + 1)] + c32 * mat_a[((i*mat_size))+(j + 1)]
-                                        + c33 * mat_a[(((i+ 1)*mat_size) )+(j + 1)]);
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
 
-                            verification_passed = almost_equal(result[{i, j}], res, .1f);
-                        }
-                    }
+    static std::string getBenchmarkName() { return "Conv2D"; }
 
-            });
-        }); */
-        QueueManager::sync();
-        return verification_passed;
+    bool verify(VerificationSetting &ver) {
+        const auto n = static_cast<size_t>(mat_size);
+        // No inner points for n <= 2
+        const size_t inner = n > 2 ? n - 2 : 0;
+        const HostInput<BENCH_DATA_TYPE> a(n, n, args.getInputFile(0), generators::Random<BENCH_DATA_TYPE>{args.seed});
+        // Indexed [row offset][column offset], so c12 weighs A[i][j - 1] and c21 weighs A[i - 1][j]
+        const BENCH_DATA_TYPE c11 = +0.2, c21 = +0.5, c31 = -0.8;
+        const BENCH_DATA_TYPE c12 = -0.3, c22 = +0.6, c32 = -0.9;
+        const BENCH_DATA_TYPE c13 = +0.4, c23 = +0.7, c33 = +0.10;
+        const BENCH_DATA_TYPE weights[] = {
+            c11, c21, c31,
+            c12, c22, c32,
+            c13, c23, c33,
+        };
+        // The kernel only writes the inner points of B
+        return verifyPartitions(QueueManager::getInstance(), mat_b_buf.get(), ver, celerity::subrange<2>{{1, 1}, {inner, inner}},
+            [&](size_t row_begin, size_t row_end, size_t col_begin, size_t col_end, BENCH_DATA_TYPE* out) {
+                host_reference::stencil2d<1>(row_begin, row_end, col_begin, col_end, n, n, a.data(), weights, out);
+            }, VerificationTolerance{1e-5});
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
+BENCHMARK_MAIN(2DConvolution, app) {
     app.run< Conv2D >();
-    return 0;
 }
@@ -38,8 +38,6 @@ void conv3D(celerity::distr_queue queue,
 
 class Conv3D {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_b;
     BenchmarkArgs args;
     int mat_size;
 
@@ -52,18 +50,8 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size * mat_size);
-        mat_b = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size * mat_size, 0.f);
-
-        // random seed
-        srand(42);
-        for(size_t i = 0; i < mat_size; ++i)
-            for(size_t j = 0; j < mat_size; ++j)
-                for(size_t k = 0; k < mat_size; ++k)
-                    mat_a[(i * (mat_size*mat_size)) + (j*mat_size) + k] = (BENCH_DATA_TYPE)rand() / RAND_MAX;
-
         auto range = celerity::range<3>(mat_size, mat_size,mat_size);
-        mat_a_buf.initialize(mat_a.data(), range);
+        mat_a_buf.initialize(range, args.getInputFile(0), generators::Random<BENCH_DATA_TYPE>{args.seed});
         mat_b_buf.initialize(range);
     }
 
@@ -74,6 +62,16 @@ public:
 
     }
 
+    static RooflineMetric getRooflineMetric(const BenchmarkArgs& args) {
+        const double n = args.problem_size;
+        // The kernel computes a single plane of (n-1)^2 points from the three neighbouring planes of A,
+        // with 15 multiplies and 14 adds per point
+        const double points = (n - 1) * (n - 1);
+        return {29.0 * points, (3.0 * n * n + points) * sizeof(BENCH_DATA_TYPE)};
+    }
+
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Conv3D"; }
 
     bool verify(VerificationSetting &ver) {
@@ -116,8 +114,6 @@ public:
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
+BENCHMARK_MAIN(3DConvolution, app) {
     app.run< Conv3D >();
 }
@@ -16,7 +16,7 @@ void multiply(celerity::distr_queue& queue,
         auto b = mat_b.template get_access<cl::sycl::access::mode::read>(cgh, celerity::access::slice<2>(0));
         auto c = mat_c.template get_access<cl::sycl::access::mode::discard_write>(cgh, celerity::access::one_to_one<2>());
 
-        cgh.parallel_for<class Matmul>(cl::sycl::range<2>(mat_size, mat_size), [=](cl::sycl::item<2> item) {
+        cgh.parallel_for<class Mm3Multiply>(cl::sycl::range<2>(mat_size, mat_size), [=](cl::sycl::item<2> item) {
             auto sum = 0.f;
             for(size_t k = 0; k < mat_size; ++k) {
                 const auto a_ik = a[{item[0], k}];
@@ -31,10 +31,6 @@ void multiply(celerity::distr_queue& queue,
 
 class mm3 {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_b;
-    std::vector<BENCH_DATA_TYPE> mat_c;
-    std::vector<BENCH_DATA_TYPE> mat_d;
     std::vector<BENCH_DATA_TYPE> mat_e;
     std::vector<BENCH_DATA_TYPE> mat_f;
     std::vector<BENCH_DATA_TYPE> mat_res;
@@ -55,25 +51,11 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_b = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_c = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_d = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-
         // Initialize matrices to the identity
-        for(size_t i = 0; i < mat_size; ++i) {
-            for(size_t j = 0; j < mat_size; ++j) {
-                mat_a[i * mat_size + j] = i == j;
-                mat_b[i * mat_size + j] = i == j;
-                mat_c[i * mat_size + j] = i == j;
-                mat_d[i * mat_size + j] = i == j;
-            }
-        }
-
-        mat_a_buf.initialize(mat_a.data(), cl::sycl::range<2>(mat_size, mat_size));
-        mat_b_buf.initialize(mat_b.data(), cl::sycl::range<2>(mat_size, mat_size));
-        mat_c_buf.initialize(mat_c.data(), cl::sycl::range<2>(mat_size, mat_size));
-        mat_d_buf.initialize(mat_d.data(), cl::sycl::range<2>(mat_size, mat_size));
+        mat_a_buf.initialize(cl::sycl::range<2>(mat_size, mat_size), generators::Identity<BENCH_DATA_TYPE>{});
+        mat_b_buf.initialize(cl::sycl::range<2>(mat_size, mat_size), generators::Identity<BENCH_DATA_TYPE>{});
+        mat_c_buf.initialize(cl::sycl::range<2>(mat_size, mat_size), generators::Identity<BENCH_DATA_TYPE>{});
+        mat_d_buf.initialize(cl::sycl::range<2>(mat_size, mat_size), generators::Identity<BENCH_DATA_TYPE>{});
         mat_e_buf.initialize(cl::sycl::range<2>(mat_size, mat_size));
         mat_f_buf.initialize(cl::sycl::range<2>(mat_size, mat_size));
         mat_res_buf.initialize(cl::sycl::range<2>(mat_size, mat_size));
@@ -94,26 +76,21 @@ public:
                  mat_res_buf.get(), mat_size);
     }
 
+    static RooflineMetric getRooflineMetric(const BenchmarkArgs& args) {
+        const double n = args.problem_size;
+        // Three matrix multiplications, each reading two matrices and writing one
+        return {3.0 * 2.0 * n * n * n, 3.0 * 3.0 * n * n * sizeof(BENCH_DATA_TYPE)};
+    }
+
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "mm3"; }
 
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        QueueManager::getInstance().with_master_access([&](celerity::handler& cgh) {
-            auto result = mat_res_buf.template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<2>(mat_size, mat_size));
-            cgh.run([=, &verification_passed]() {
-                for(size_t i = 0; i < mat_size && verification_passed; ++i)
-                    for(size_t j = 0; j < mat_size && verification_passed; ++j){
-                        verification_passed = result[{i, j}] == (i == j);
-                    }
-            });
-        });
-        QueueManager::sync();
-        return verification_passed;
+        return verifyPartitions(QueueManager::getInstance(), mat_res_buf.get(), ver, generators::Identity<BENCH_DATA_TYPE>{});
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
+BENCHMARK_MAIN(3mm, app) {
     app.run< mm3 >();
 }
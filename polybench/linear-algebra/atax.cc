@@ -12,13 +12,13 @@ void atax(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE, 2> mat_
                 celerity::buffer<BENCH_DATA_TYPE, 2> mat_tmp,const size_t mat_size) {
 
 #if BENCH_KERNEL == 1 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Atax1", [=](celerity::handler& cgh) {
         celerity::accessor y{mat_y, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
         cgh.parallel_for<class Atax1>(celerity::range<2>(mat_size, 1), [=](celerity::item<2> item) { y[item] = 0; });
     });
 #endif
 #if BENCH_KERNEL == 2 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Atax2", [=](celerity::handler& cgh) {
         celerity::accessor A{mat_a, cgh, celerity::access::slice<2>(1), celerity::read_only};
         celerity::accessor x{mat_x, cgh, celerity::access::all{}, celerity::read_only};
         celerity::accessor tmp{mat_tmp, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
@@ -34,7 +34,7 @@ void atax(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE, 2> mat_
     });
 #endif
 #if BENCH_KERNEL == 3 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Atax3", [=](celerity::handler& cgh) {
         celerity::accessor A{mat_a, cgh, celerity::access::slice<2>(0), celerity::read_only};
         celerity::accessor tmp{mat_tmp, cgh, celerity::access::all{}, celerity::read_only};
         celerity::accessor y{mat_y, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
@@ -54,10 +54,6 @@ void atax(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE, 2> mat_
 
 class Atax {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_x;
-    std::vector<BENCH_DATA_TYPE> mat_y;
-    std::vector<BENCH_DATA_TYPE> mat_tmp;
     BenchmarkArgs args;
     int mat_size;
 
@@ -72,20 +68,10 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_x = std::vector<BENCH_DATA_TYPE>(mat_size);
-        mat_y = std::vector<BENCH_DATA_TYPE>(mat_size);
-        mat_tmp = std::vector<BENCH_DATA_TYPE>(mat_size);
-
-        for(size_t i = 0; i < mat_size; ++i) {
-            for(size_t j = 0; j < mat_size; ++j) {
-                mat_a[i * mat_size + j] = ((BENCH_DATA_TYPE)i * (j)) / mat_size;
-            }
-        }
-
-        mat_a_buf.initialize(mat_a.data(), celerity::range<2>(mat_size, mat_size));
-        mat_x_buf.initialize(mat_x.data(), celerity::range<2>(mat_size, 1));
-        mat_y_buf.initialize(mat_y.data(), celerity::range<2>(mat_size, 1));
+        mat_a_buf.initialize(celerity::range<2>(mat_size, mat_size), generators::Affine<BENCH_DATA_TYPE>{0, 0, 0, (BENCH_DATA_TYPE)mat_size});
+        // x[i] = (i + 1) / n, so that y = A^T * A * x is not identically zero
+        mat_x_buf.initialize(celerity::range<2>(mat_size, 1), generators::Affine<BENCH_DATA_TYPE>{1, 1, 0, (BENCH_DATA_TYPE)mat_size});
+        mat_y_buf.initialize(celerity::range<2>(mat_size, 1), generators::Constant<BENCH_DATA_TYPE>{0});
         mat_tmp_buf.initialize(            celerity::range<2>(mat_size, 1));
     }
 
@@ -93,31 +79,24 @@ public:
         atax(QueueManager::getInstance(), mat_a_buf.get(), mat_x_buf.get(),mat_y_buf.get(),mat_tmp_buf.get(),mat_size);
     }
 
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Atax"; }
 
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        /*QueueManager::getInstance().with_master_access([&](celerity::handler& cgh) {
-            auto result = mat_y_buf.template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<2>(mat_size,1));
-            cgh.run([=, &verification_passed]() {
-                std::vector<BENCH_DATA_TYPE> test_y(mat_size,0.f);
-                std::vector<BENCH_DATA_TYPE> test_tmp(mat_size,0.f);
-                for(size_t i = 0; i < mat_size && verification_passed; ++i){
-                    for(size_t j = 0; j < mat_size; ++j)
-                        test_tmp[i] = test_tmp[i] + mat_a[i * mat_size + j] * mat_x[j];
-                    for(size_t j = 0; j < mat_size; ++j)
-                        test_y[j] = test_y[j] + mat_a[i * mat_size + j] * test_tmp[i];
-
-                    verification_passed =  almost_equal(test_y[i], result[{i,0}],3);
-                }
-            });
-        });*/
-        QueueManager::sync();
-        return verification_passed;
+        const auto n = static_cast<size_t>(mat_size);
+        const HostInput<BENCH_DATA_TYPE> a(n, n, nullptr, generators::Affine<BENCH_DATA_TYPE>{0, 0, 0, (BENCH_DATA_TYPE)n});
+        const HostInput<BENCH_DATA_TYPE> x(n, 1, nullptr, generators::Affine<BENCH_DATA_TYPE>{1, 1, 0, (BENCH_DATA_TYPE)n});
+        // y = A^T * (A * x), where every node needs all of A * x
+        HostVector<BENCH_DATA_TYPE> tmp(n);
+        host_reference::gemv<BENCH_DATA_TYPE>(0, n, n, 1, a.view(), x.data(), 0, nullptr, tmp.data());
+        return verifyPartitions(QueueManager::getInstance(), mat_y_buf.get(), ver,
+            [&](size_t row_begin, size_t row_end, size_t, size_t, BENCH_DATA_TYPE* out) {
+                host_reference::gemv<BENCH_DATA_TYPE>(row_begin, row_end, n, 1, a.view().transposed(), tmp.data(), 0, nullptr, out);
+            }, VerificationTolerance{0, 1e-3});
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(atax, app) {
     app.run< Atax >();
 }
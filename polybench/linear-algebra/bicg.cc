@@ -17,7 +17,7 @@ void bicg(celerity::distr_queue queue,
           const size_t mat_size) {
 
 #if BENCH_KERNEL == 1 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Bicg1", [=](celerity::handler& cgh) {
         celerity::accessor A{mat_a, cgh, celerity::access::slice<2>(1), celerity::read_only};
         celerity::accessor p{mat_p, cgh, celerity::access::all{}, celerity::read_only};
         celerity::accessor q{mat_q, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
@@ -34,7 +34,7 @@ void bicg(celerity::distr_queue queue,
     });
 #endif
 #if BENCH_KERNEL == 2 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Bicg2", [=](celerity::handler& cgh) {
         celerity::accessor A{mat_a, cgh, celerity::access::slice<2>(0), celerity::read_only}; // todo verify
         celerity::accessor r{mat_r, cgh, celerity::access::all{}, celerity::read_only};
         celerity::accessor s{mat_s, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
@@ -55,11 +55,11 @@ void bicg(celerity::distr_queue queue,
 
 class Bicg {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_r;
-    std::vector<BENCH_DATA_TYPE> mat_s;
-    std::vector<BENCH_DATA_TYPE> mat_p;
-    std::vector<BENCH_DATA_TYPE> mat_q;
+    HostVector<BENCH_DATA_TYPE> mat_a;
+    HostVector<BENCH_DATA_TYPE> mat_r;
+    HostVector<BENCH_DATA_TYPE> mat_s;
+    HostVector<BENCH_DATA_TYPE> mat_p;
+    HostVector<BENCH_DATA_TYPE> mat_q;
     BenchmarkArgs args;
     int mat_size;
 
@@ -75,20 +75,13 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_r = std::vector<BENCH_DATA_TYPE>(mat_size);
-        mat_s = std::vector<BENCH_DATA_TYPE>(mat_size,0.f);
-        mat_p = std::vector<BENCH_DATA_TYPE>(mat_size);
-        mat_q = std::vector<BENCH_DATA_TYPE>(mat_size,0.f);
-
-        for(size_t i = 0; i < mat_size; ++i) {
-            mat_r[i] = i * M_PI;
-            mat_p[i] = i * M_PI;
-            for(size_t j = 0; j < mat_size; ++j) {
-                mat_a[i * mat_size + j] = ((BENCH_DATA_TYPE)i * j)/mat_size;
-
-            }
-        }
+        mat_a = makeHostMatrix<BENCH_DATA_TYPE>(mat_size, mat_size, [&](size_t i, size_t j) {
+            return ((BENCH_DATA_TYPE)i * j)/mat_size;
+        });
+        mat_r = makeHostVector<BENCH_DATA_TYPE>(mat_size, [](size_t i) { return i * M_PI; });
+        mat_s = makeHostVector<BENCH_DATA_TYPE>(mat_size,0.f);
+        mat_p = makeHostVector<BENCH_DATA_TYPE>(mat_size, [](size_t i) { return i * M_PI; });
+        mat_q = makeHostVector<BENCH_DATA_TYPE>(mat_size,0.f);
 
         mat_a_buf.initialize(mat_a.data(), celerity::range<2>(mat_size, mat_size));
         mat_r_buf.initialize(mat_r.data(), celerity::range<2>(mat_size, 1));
@@ -104,38 +97,38 @@ public:
              mat_q_buf.get(), mat_size);
     }
 
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Bicg"; }
 
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        /* QueueManager::getInstance().with_master_access([&](celerity::handler& cgh) {
-            auto ress = mat_s_buf.get().template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<2>(mat_size, 1));
-            auto resq = mat_q_buf.get().template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<2>(mat_size, 1));
-            cgh.run([=, &verification_passed]() {
-                std::vector<BENCH_DATA_TYPE> test_q(mat_size,0.f);
-                std::vector<BENCH_DATA_TYPE> test_s(mat_size,0.f);
-                for (int i = 0; i < mat_size; i++) {
-                    for (int j = 0; j < mat_size; j++) {
-                        test_s[j] = test_s[j] + mat_r[i] * mat_a[i * mat_size + j];
-                        test_q[i] = test_q[i] + mat_a[i * mat_size + j] * mat_p[j];
-                    }
-                }
-                for (int i=0;i<test_s.size() && verification_passed;i++) {
-                    verification_passed =
-                            almost_equal(ress[i][0], test_s[i], 3);
-                }
-                for (int i=0;i<test_q.size() && verification_passed;i++) {
-                    verification_passed =
-                            almost_equal(resq[i][0], test_q[i], 3);
-                }
-            });
-        });*/
-        QueueManager::sync();
-        return verification_passed;
+        const auto n = static_cast<size_t>(mat_size);
+        const host_reference::MatrixView<BENCH_DATA_TYPE> a{mat_a.data(), n};
+        // A kernel that is compiled out leaves its result at 0
+#if BENCH_KERNEL == 1 || !defined( BENCH_KERNEL )
+        const BENCH_DATA_TYPE q_scale = 1;
+#else
+        const BENCH_DATA_TYPE q_scale = 0;
+#endif
+#if BENCH_KERNEL == 2 || !defined( BENCH_KERNEL )
+        const BENCH_DATA_TYPE s_scale = 1;
+#else
+        const BENCH_DATA_TYPE s_scale = 0;
+#endif
+        // q = A * p
+        const bool q_pass = verifyPartitions(QueueManager::getInstance(), mat_q_buf.get(), ver,
+            [&](size_t row_begin, size_t row_end, size_t, size_t, BENCH_DATA_TYPE* out) {
+                host_reference::gemv<BENCH_DATA_TYPE>(row_begin, row_end, n, q_scale, a, mat_p.data(), 0, nullptr, out);
+            }, VerificationTolerance{0, 1e-3});
+        // s = A * r, as the kernel reads A[j][i]
+        const bool s_pass = verifyPartitions(QueueManager::getInstance(), mat_s_buf.get(), ver,
+            [&](size_t row_begin, size_t row_end, size_t, size_t, BENCH_DATA_TYPE* out) {
+                host_reference::gemv<BENCH_DATA_TYPE>(row_begin, row_end, n, s_scale, a, mat_r.data(), 0, nullptr, out);
+            }, VerificationTolerance{0, 1e-3});
+        return q_pass && s_pass;
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(bicg, app) {
     app.run< Bicg >();
 }
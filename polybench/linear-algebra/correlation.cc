@@ -19,7 +19,7 @@ void correlation(celerity::distr_queue queue,
                  const size_t mat_size) {
     using namespace cl::sycl;
 #if BENCH_KERNEL == 1 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Correlation1", [=](celerity::handler& cgh) {
         celerity::accessor data{d, cgh, celerity::access::slice<2>(0), celerity::read_only};
         celerity::accessor mean{m, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
         cgh.parallel_for<class Correlation1>(range<2>(mat_size, 1), id<2>(1, 0), [=, N_ = mat_size](celerity::item<2> item) {
@@ -34,7 +34,7 @@ void correlation(celerity::distr_queue queue,
     });
 #endif
 #if BENCH_KERNEL == 2 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Correlation2", [=](celerity::handler& cgh) {
         celerity::accessor data{d, cgh, celerity::access::slice<2>(0), celerity::read_only};
         celerity::accessor mean{m, cgh, celerity::access::one_to_one{}, celerity::read_only};
         celerity::accessor stddev{sd, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
@@ -53,7 +53,7 @@ void correlation(celerity::distr_queue queue,
     });
 #endif
 #if BENCH_KERNEL == 3 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Correlation3", [=](celerity::handler& cgh) {
         celerity::accessor data{d, cgh, celerity::access::one_to_one{}, celerity::read_write};
         celerity::accessor mean{m, cgh, celerity::access::all{}, celerity::read_only};
         celerity::accessor stddev{sd, cgh, celerity::access::all{}, celerity::read_only};
@@ -71,9 +71,10 @@ void correlation(celerity::distr_queue queue,
 
 #endif
 #if BENCH_KERNEL == 4 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Correlation4", [=](celerity::handler& cgh) {
         celerity::accessor data{d, cgh, celerity::access::all{}, celerity::read_only};
-        celerity::accessor symmat{sym, cgh, celerity::access::slice<2>(1), celerity::write_only, celerity::no_init};
+        // Not no_init: the kernel only writes the upper triangle of the rows it accesses, the rest keeps its zeros
+        celerity::accessor symmat{sym, cgh, celerity::access::slice<2>(1), celerity::write_only};
         //celerity::accessor symmat2{sym, cgh, celerity::access::slice<2>(0), celerity::write_only, celerity::no_init};
         cgh.parallel_for<class Correlation4>(range<2>(mat_size - 1, 1), id<2>(1, 0), [=, M_ = mat_size, N_ = mat_size](celerity::item<2> item) {
             const auto j1 = item[0];
@@ -103,10 +104,10 @@ void correlation(celerity::distr_queue queue,
 
 class Correlation {
 protected:
-    std::vector<BENCH_DATA_TYPE> data;
-    std::vector<BENCH_DATA_TYPE> mean;
-    std::vector<BENCH_DATA_TYPE> stddev;
-    std::vector<BENCH_DATA_TYPE> symmat;
+    HostVector<BENCH_DATA_TYPE> data;
+    HostVector<BENCH_DATA_TYPE> mean;
+    HostVector<BENCH_DATA_TYPE> stddev;
+    HostVector<BENCH_DATA_TYPE> symmat;
     BenchmarkArgs args;
     int mat_size;
 
@@ -120,19 +121,28 @@ public:
         mat_size = args.problem_size;
     }
 
+    // The first n * n elements of the data matrix in row-major order hold i * j / (n + 1) for an n x n matrix, the rest is zero
+    static auto dataGenerator(size_t n) {
+        return [n](size_t row, size_t col) {
+            const size_t k = row * (n + 1) + col;
+            const size_t i = k / n, j = k % n;
+            return k < n * n ? ((BENCH_DATA_TYPE)i * j) / (n + 1) : BENCH_DATA_TYPE{0};
+        };
+    }
+
     void setup() {
-        data = std::vector<BENCH_DATA_TYPE>((mat_size+1) * (mat_size+1));
-        mean = std::vector<BENCH_DATA_TYPE>((mat_size+1));
-        stddev = std::vector<BENCH_DATA_TYPE>((mat_size+1));
-        symmat = std::vector<BENCH_DATA_TYPE>((mat_size+1)*(mat_size+1));
-
-        for(size_t i = 0; i < mat_size; ++i) {
-            for(size_t j = 0; j < mat_size; ++j) {
-                data[i*mat_size+j] = ((BENCH_DATA_TYPE)i * j) / (mat_size + 1);
-            }
+        if(!args.getInputFile(0)) {
+            data = makeHostMatrix<BENCH_DATA_TYPE>((mat_size+1), (mat_size+1), dataGenerator(mat_size));
+        }
+        mean = makeHostVector<BENCH_DATA_TYPE>((mat_size+1));
+        stddev = makeHostVector<BENCH_DATA_TYPE>((mat_size+1));
+        symmat = makeHostVector<BENCH_DATA_TYPE>((mat_size+1)*(mat_size+1));
+
+        if(auto file = args.getInputFile(0)) {
+            data_buf.initialize(celerity::range<2>((mat_size+1), (mat_size+1)), file);
+        } else {
+            data_buf.initialize(data.data(), celerity::range<2>((mat_size+1), (mat_size+1)));
         }
-
-        data_buf.initialize(data.data(),     celerity::range<2>((mat_size+1), (mat_size+1)));
         mean_buf.initialize(mean.data(),     celerity::range<2>((mat_size+1), 1));
         stddev_buf.initialize(stddev.data(), celerity::range<2>((mat_size+1), 1));
         symmat_buf.initialize(symmat.data(), celerity::range<2>((mat_size+1), (mat_size+1)));
@@ -144,18 +154,62 @@ public:
                     stddev_buf.get(), symmat_buf.get(),mat_size);
     }
 
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Correlation"; }
 
+#if !defined( BENCH_KERNEL )
+    // A single kernel of the chain reads intermediate results that no other kernel has written, so only the whole chain is verified
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        //todo
-        QueueManager::sync();
-        return verification_passed;
+        const auto n = static_cast<size_t>(mat_size);
+        const HostInput<BENCH_DATA_TYPE> input(n + 1, n + 1, args.getInputFile(0), dataGenerator(n));
+        // Normalize the columns 1..n over the rows 1..n in the order of Correlation1 to Correlation3
+        HostVector<BENCH_DATA_TYPE> normalized(input.data(), input.data() + (n + 1) * (n + 1));
+        parallelFor(n, [&](size_t c) {
+            const size_t j = c + 1;
+            const auto at = [&](size_t i) -> BENCH_DATA_TYPE& { return normalized[i * (n + 1) + j]; };
+
+            BENCH_DATA_TYPE mean = 0;
+            for(size_t i = 1; i <= n; i++) mean += at(i);
+            mean = mean / ((BENCH_DATA_TYPE)FLOAT_N);
+
+            BENCH_DATA_TYPE stddev = 0;
+            for(size_t i = 1; i <= n; i++) stddev += (at(i) - mean) * (at(i) - mean);
+            stddev /= FLOAT_N;
+            stddev = std::sqrt(stddev);
+            stddev = stddev <= EPS ? 1.0 : stddev;
+
+            for(size_t i = 1; i <= n; i++) {
+                auto result = at(i);
+                result -= mean;
+                result /= std::sqrt(FLOAT_N);
+                result /= stddev;
+                at(i) = result;
+            }
+        }, 1);
+        // Rows and columns 1..n of the normalized data
+        const host_reference::MatrixView<BENCH_DATA_TYPE> d{normalized.data() + n + 2, n + 1};
+
+        // symmat[j1][j1] = 1 and symmat[j1][j2] = sum of data[i][j1] * data[i][j2] over i for 1 <= j1 < j2 <= n,
+        // the rest (including symmat[n][n]) stays 0
+        return verifyPartitions(QueueManager::getInstance(), symmat_buf.get(), ver,
+            [&](size_t row_begin, size_t row_end, size_t col_begin, size_t col_end, BENCH_DATA_TYPE* out) {
+                const size_t cols = col_end - col_begin;
+                std::fill(out, out + (row_end - row_begin) * cols, BENCH_DATA_TYPE{0});
+                const size_t r0 = std::max<size_t>(row_begin, 1), r1 = std::min(row_end, n), c0 = std::max<size_t>(col_begin, 1);
+                if(r0 >= r1 || c0 >= col_end) return;
+                HostVector<BENCH_DATA_TYPE> block((r1 - r0) * (col_end - c0));
+                host_reference::gemm<BENCH_DATA_TYPE>(r0 - 1, r1 - 1, c0 - 1, col_end - 1, n, 1, d.transposed(), d, 0, {}, block.data());
+                for(size_t i = r0; i < r1; i++) {
+                    for(size_t j = std::max(c0, i); j < col_end; j++) {
+                        out[(i - row_begin) * cols + (j - col_begin)] = j == i ? 1 : block[(i - r0) * (col_end - c0) + (j - c0)];
+                    }
+                }
+            }, VerificationTolerance{0, 1e-3});
     }
+#endif
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
+BENCHMARK_MAIN(correlation, app) {
     app.run< Correlation >();
 }
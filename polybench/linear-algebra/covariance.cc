@@ -8,9 +8,9 @@
 
 using BENCH_DATA_TYPE = float;
 
-class Correlation;
+class Covariance;
 
-void correlation(celerity::distr_queue queue,
+void covariance(celerity::distr_queue queue,
                  celerity::buffer<BENCH_DATA_TYPE, 2> d,
                  celerity::buffer<BENCH_DATA_TYPE, 2> m,
                  celerity::buffer<BENCH_DATA_TYPE, 2> sd,
@@ -20,7 +20,7 @@ void correlation(celerity::distr_queue queue,
     using namespace celerity::access;
 
 #if BENCH_KERNEL == 1 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Covariance1", [=](celerity::handler& cgh) {
         celerity::accessor data{d, cgh, celerity::access::slice<2>(0), celerity::read_only};
         celerity::accessor mean{m, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
         cgh.parallel_for<class Covariance1>(range<2>(mat_size, 1), id<2>(1, 0), [=, N_ = mat_size](celerity::item<2> item) {
@@ -35,7 +35,7 @@ void correlation(celerity::distr_queue queue,
     });
 #endif
 #if BENCH_KERNEL == 2 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Covariance2", [=](celerity::handler& cgh) {
         celerity::accessor mean{m, cgh, celerity::access::slice<2>(1), celerity::read_only};
         celerity::accessor data{d, cgh, celerity::access::one_to_one{}, celerity::read_write};
         cgh.parallel_for<class Covariance2>(range<2>(mat_size, mat_size), id<2>(1, 1), [=](celerity::item<2> item) {
@@ -46,9 +46,10 @@ void correlation(celerity::distr_queue queue,
 
 #endif
 #if BENCH_KERNEL == 3 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Covariance3", [=](celerity::handler& cgh) {
         celerity::accessor data{d, cgh, celerity::access::all{}, celerity::read_only};
-        celerity::accessor symmat{sd, cgh, celerity::access::slice<2>(1), celerity::write_only, celerity::no_init};
+        // Not no_init: the kernel only writes the upper triangle of the rows it accesses, the rest keeps its zeros
+        celerity::accessor symmat{sd, cgh, celerity::access::slice<2>(1), celerity::write_only};
         //celerity::accessor symmat2{sd, cgh, celerity::access::slice<2>(0), celerity::write_only, celerity::no_init};
 
         cgh.parallel_for<class Covariance3>(range<2>(mat_size, 1), id<2>(1, 0), [=, M_ = mat_size, N_ = mat_size](celerity::item<2> item) {
@@ -71,11 +72,11 @@ void correlation(celerity::distr_queue queue,
 }
 
 
-class Correlation {
+class Covariance {
 protected:
-    std::vector<BENCH_DATA_TYPE> data;
-    std::vector<BENCH_DATA_TYPE> mean;
-    std::vector<BENCH_DATA_TYPE> symmat;
+    HostVector<BENCH_DATA_TYPE> data;
+    HostVector<BENCH_DATA_TYPE> mean;
+    HostVector<BENCH_DATA_TYPE> symmat;
     BenchmarkArgs args;
     int mat_size;
 
@@ -84,44 +85,75 @@ protected:
     PrefetchedBuffer<BENCH_DATA_TYPE, 2> symmat_buf;
 
 public:
-    Correlation(const BenchmarkArgs &_args) : args(_args) {
+    Covariance(const BenchmarkArgs &_args) : args(_args) {
         mat_size = args.problem_size;
     }
 
-    void setup() {
-        data = std::vector<BENCH_DATA_TYPE>((mat_size+1) * (mat_size+1));
-        mean = std::vector<BENCH_DATA_TYPE>((mat_size+1));
-        symmat = std::vector<BENCH_DATA_TYPE>((mat_size+1)*(mat_size+1));
+    // data[i][j] = i * j / n, with a zero last row and column
+    static auto dataGenerator(size_t n) {
+        return [n](size_t i, size_t j) { return i < n && j < n ? ((BENCH_DATA_TYPE)i * j) / n : BENCH_DATA_TYPE{0}; };
+    }
 
-        for(size_t i = 0; i < mat_size; ++i) {
-            for(size_t j = 0; j < mat_size; ++j) {
-                data[i*(mat_size+1)+j] = ((BENCH_DATA_TYPE)i * j) / (mat_size);
-            }
+    void setup() {
+        if(!args.getInputFile(0)) {
+            data = makeHostMatrix<BENCH_DATA_TYPE>((mat_size+1), (mat_size+1), dataGenerator(mat_size));
         }
+        mean = makeHostVector<BENCH_DATA_TYPE>((mat_size+1));
+        symmat = makeHostVector<BENCH_DATA_TYPE>((mat_size+1)*(mat_size+1));
 
-        data_buf.initialize(data.data(),     celerity::range<2>((mat_size+1), (mat_size+1)));
+        if(auto file = args.getInputFile(0)) {
+            data_buf.initialize(celerity::range<2>((mat_size+1), (mat_size+1)), file);
+        } else {
+            data_buf.initialize(data.data(), celerity::range<2>((mat_size+1), (mat_size+1)));
+        }
         mean_buf.initialize(mean.data(),     celerity::range<2>((mat_size+1), 1));
         symmat_buf.initialize(symmat.data(), celerity::range<2>((mat_size+1), (mat_size+1)));
     }
 
     void run() {
-        correlation(QueueManager::getInstance(),
+        covariance(QueueManager::getInstance(),
                     data_buf.get(), mean_buf.get()
                     , symmat_buf.get(),mat_size);
     }
 
-    static std::string getBenchmarkName() { return "Correlation"; }
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
+    static std::string getBenchmarkName() { return "Covariance"; }
 
+#if !defined( BENCH_KERNEL )
+    // A single kernel of the chain reads intermediate results that no other kernel has written, so only the whole chain is verified
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        //todo
-        QueueManager::sync();
-        return verification_passed;
+        const auto n = static_cast<size_t>(mat_size);
+        const HostInput<BENCH_DATA_TYPE> input(n + 1, n + 1, args.getInputFile(0), dataGenerator(n));
+        // Subtract the mean of the columns 1..n over the rows 1..n in the order of Covariance1 and Covariance2
+        HostVector<BENCH_DATA_TYPE> centered(input.data(), input.data() + (n + 1) * (n + 1));
+        parallelFor(n, [&](size_t c) {
+            const size_t j = c + 1;
+            BENCH_DATA_TYPE mean = 0;
+            for(size_t i = 1; i <= n; i++) mean += centered[i * (n + 1) + j];
+            mean = mean / FLOAT_N;
+            for(size_t i = 1; i <= n; i++) centered[i * (n + 1) + j] -= mean;
+        }, 1);
+        // Rows and columns 1..n of the centered data
+        const host_reference::MatrixView<BENCH_DATA_TYPE> d{centered.data() + n + 2, n + 1};
+
+        // symmat[j1][j2] = sum of data[i][j1] * data[i][j2] over i for 1 <= j1 <= j2 <= n, the rest stays 0
+        return verifyPartitions(QueueManager::getInstance(), symmat_buf.get(), ver,
+            [&](size_t row_begin, size_t row_end, size_t col_begin, size_t col_end, BENCH_DATA_TYPE* out) {
+                const size_t cols = col_end - col_begin;
+                std::fill(out, out + (row_end - row_begin) * cols, BENCH_DATA_TYPE{0});
+                const size_t r0 = std::max<size_t>(row_begin, 1), c0 = std::max<size_t>(col_begin, 1);
+                if(r0 >= row_end || c0 >= col_end) return;
+                HostVector<BENCH_DATA_TYPE> block((row_end - r0) * (col_end - c0));
+                host_reference::gemm<BENCH_DATA_TYPE>(r0 - 1, row_end - 1, c0 - 1, col_end - 1, n, 1, d.transposed(), d, 0, {}, block.data());
+                for(size_t i = r0; i < row_end; i++)
+                    for(size_t j = std::max(c0, i); j < col_end; j++)
+                        out[(i - row_begin) * cols + (j - col_begin)] = block[(i - r0) * (col_end - c0) + (j - c0)];
+            }, VerificationTolerance{0, 1e-3});
     }
+#endif
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
-    app.run< Correlation >();
+BENCHMARK_MAIN(covariance, app) {
+    app.run< Covariance >();
 }
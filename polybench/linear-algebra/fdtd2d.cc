@@ -18,7 +18,7 @@ void fdtd2d(celerity::distr_queue queue,
     using namespace celerity::access;
     for(size_t t = 0; t < TMAX; t++) {
 #if BENCH_KERNEL == 1 || !defined( BENCH_KERNEL )
-        queue.submit([=](celerity::handler& cgh) {
+        KernelProfiler::submit(queue, "Fdtd2d1", [=](celerity::handler& cgh) {
             celerity::accessor fict{fict_buf, cgh, celerity::access::fixed<2>({{t, 0}, {1, 1}}), celerity::read_only};
             //celerity::accessor fict{fict_buf, cgh, celerity::access::all{}, celerity::read_only};
             celerity::accessor ey{ey_buf, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
@@ -26,7 +26,7 @@ void fdtd2d(celerity::distr_queue queue,
         });
 #endif
 #if BENCH_KERNEL == 2 || !defined( BENCH_KERNEL )
-        queue.submit([=](celerity::handler& cgh) {
+        KernelProfiler::submit(queue, "Fdtd2d2", [=](celerity::handler& cgh) {
             celerity::accessor ey{ey_buf, cgh, celerity::access::one_to_one{}, celerity::read_write};
             celerity::accessor hz{hz_buf, cgh, celerity::access::neighborhood<2>(1,1), celerity::read_only};
             cgh.parallel_for<class Fdtd2d2>(range<2>(mat_size - 1, mat_size), id<2>(1, 0), [=](celerity::item<2> item) {
@@ -37,7 +37,7 @@ void fdtd2d(celerity::distr_queue queue,
         });
 #endif
 #if BENCH_KERNEL == 3 || !defined( BENCH_KERNEL )
-        queue.submit([=](celerity::handler& cgh) {
+        KernelProfiler::submit(queue, "Fdtd2d3", [=](celerity::handler& cgh) {
             celerity::accessor ex{ex_buf, cgh, celerity::access::one_to_one{}, celerity::read_write};
             celerity::accessor hz{hz_buf, cgh, celerity::access::neighborhood<2>(1,1), celerity::read_only};
             cgh.parallel_for<class Fdtd2d3>(range<2>(mat_size, mat_size - 1), id<2>(0, 1), [=](celerity::item<2> item) {
@@ -48,7 +48,7 @@ void fdtd2d(celerity::distr_queue queue,
         });
 #endif
 #if BENCH_KERNEL == 4 || !defined( BENCH_KERNEL )
-        queue.submit([=](celerity::handler& cgh) {
+        KernelProfiler::submit(queue, "Fdtd2d4", [=](celerity::handler& cgh) {
             celerity::accessor ex{ex_buf, cgh, celerity::access::neighborhood<2>(1,1), celerity::read_only};
             celerity::accessor ey{ey_buf, cgh, celerity::access::neighborhood<2>(1,1), celerity::read_only};
             celerity::accessor hz{hz_buf, cgh, celerity::access::one_to_one{}, celerity::read_write};
@@ -92,11 +92,12 @@ public:
         for(size_t i = 0; i < TMAX; i++)
             fict[i] = (BENCH_DATA_TYPE)i;
 
+        // ex has mat_size + 1 columns; its last column and the last row of ey stay 0
         for(size_t i = 0; i < mat_size; ++i) {
             for(size_t j = 0; j < mat_size; ++j) {
-                ex[i * mat_size + j] = ((BENCH_DATA_TYPE)i * (j + 1) + 1) / mat_size;
-                ey[i * mat_size + j] = ((BENCH_DATA_TYPE)(i - 1) * (j + 2) + 2) / mat_size;
-                hz[i * mat_size + j] = ((BENCH_DATA_TYPE)(i - 9) * (j + 4) + 3) / mat_size;
+                ex[i * (mat_size + 1) + j] = ((BENCH_DATA_TYPE)i * (j + 1) + 1) / mat_size;
+                ey[i * mat_size + j] = (((BENCH_DATA_TYPE)i - 1) * (j + 2) + 2) / mat_size;
+                hz[i * mat_size + j] = (((BENCH_DATA_TYPE)i - 9) * (j + 4) + 3) / mat_size;
             }
         }
 
@@ -113,18 +114,53 @@ public:
               mat_size);
     }
 
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Fdtd2d"; }
 
+#if !defined( BENCH_KERNEL )
+    // A single kernel of the chain does not advance the fields in time, so only the whole chain is verified
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        //todo
-        QueueManager::sync();
-        return verification_passed;
+        const size_t n = mat_size;
+        // Every time step depends on the whole previous one, so every node simulates all fields with the expressions of the kernels
+        auto ex_ref = ex;
+        auto ey_ref = ey;
+        auto hz_ref = hz;
+        const size_t rows_per_thread = std::max<size_t>(1, (1 << 14) / std::max<size_t>(1, n));
+        for(size_t t = 0; t < TMAX; t++) {
+            for(size_t j = 0; j < n; j++) ey_ref[j] = fict[t];
+            parallelFor(n, [&](size_t i) {
+                if(i == 0) return;
+                for(size_t j = 0; j < n; j++) {
+                    ey_ref[i * n + j] = ey_ref[i * n + j] - 0.5 * (hz_ref[i * n + j] - hz_ref[(i - 1) * n + j]);
+                }
+            }, rows_per_thread);
+            parallelFor(n, [&](size_t i) {
+                for(size_t j = 1; j < n; j++) {
+                    ex_ref[i * (n + 1) + j] = ex_ref[i * (n + 1) + j] - 0.5 * (hz_ref[i * n + j] - hz_ref[i * n + (j - 1)]);
+                }
+            }, rows_per_thread);
+            parallelFor(n, [&](size_t i) {
+                for(size_t j = 0; j < n; j++) {
+                    hz_ref[i * n + j] = hz_ref[i * n + j]
+                        - 0.7 * (ex_ref[i * (n + 1) + (j + 1)] - ex_ref[i * (n + 1) + j] + ey_ref[(i + 1) * n + j] - ey_ref[i * n + j]);
+                }
+            }, rows_per_thread);
+        }
+
+        // Rounding differences stay far below 1 while the fields grow to several thousand, but values near 0 have no relative accuracy
+        const VerificationTolerance tolerance{0.05, 1e-3};
+        const bool ex_pass = verifyPartitions(QueueManager::getInstance(), ex_buf.get(), ver,
+            [&](size_t i, size_t j) { return ex_ref[i * (n + 1) + j]; }, tolerance);
+        const bool ey_pass = verifyPartitions(QueueManager::getInstance(), ey_buf.get(), ver,
+            [&](size_t i, size_t j) { return ey_ref[i * n + j]; }, tolerance);
+        const bool hz_pass = verifyPartitions(QueueManager::getInstance(), hz_buf.get(), ver,
+            [&](size_t i, size_t j) { return hz_ref[i * n + j]; }, tolerance);
+        return ex_pass && ey_pass && hz_pass;
     }
+#endif
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
+BENCHMARK_MAIN(fdtd2d, app) {
     app.run< Fdtd2d >();
 }
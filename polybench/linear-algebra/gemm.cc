@@ -37,9 +37,6 @@ class Gemm;
 
 class Gemm {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_b;
-    std::vector<BENCH_DATA_TYPE> mat_res;
     BenchmarkArgs args;
     int mat_size;
 
@@ -53,65 +50,40 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_b = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_res = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-
-        for(size_t i = 0; i < mat_size; ++i) {
-            for(size_t j = 0; j < mat_size; ++j) {
-                mat_a[i * mat_size + j] = ((BENCH_DATA_TYPE)i * j) / mat_size;
-                mat_b[i * mat_size + j] = ((BENCH_DATA_TYPE)i * j +1)  / mat_size;
-                mat_res[i * mat_size + j] = ((BENCH_DATA_TYPE)i * j +2) / mat_size;
-            }
-        }
-
         auto range = celerity::range<2>(mat_size, mat_size);
-        mat_a_buf.initialize(mat_a.data(), range);
-        mat_b_buf.initialize(mat_b.data(), range);
-        mat_res_buf.initialize(mat_res.data(), range);
+        mat_a_buf.initialize(range, args.getInputFile(0), generators::Affine<BENCH_DATA_TYPE>{0, 0, 0, (BENCH_DATA_TYPE)mat_size});
+        mat_b_buf.initialize(range, args.getInputFile(1), generators::Affine<BENCH_DATA_TYPE>{0, 0, 1, (BENCH_DATA_TYPE)mat_size});
+        mat_res_buf.initialize(range, args.getInputFile(2), generators::Affine<BENCH_DATA_TYPE>{0, 0, 2, (BENCH_DATA_TYPE)mat_size});
     }
 
     void run() {
         gemm(QueueManager::getInstance(), mat_a_buf.get(), mat_b_buf.get(), mat_res_buf.get(),mat_size);
     }
 
+    static RooflineMetric getRooflineMetric(const BenchmarkArgs& args) {
+        const double n = args.problem_size;
+        // res = beta * res + alpha * a * b: one multiply per element plus three operations per step of the inner product;
+        // reads a and b, reads and writes res
+        return {n * n * (3.0 * n + 1.0), 4.0 * n * n * sizeof(BENCH_DATA_TYPE)};
+    }
+
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Gemm"; }
 
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        /* QueueManager::getInstance().with_master_access([&](celerity::handler& cgh) {
-            auto result = mat_res_buf.template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<2>(mat_size, mat_size));
-            cgh.run([=, &verification_passed]() {
-
-                std::vector<BENCH_DATA_TYPE>test(mat_size * mat_size);
-                std::vector<BENCH_DATA_TYPE>test_a(mat_size * mat_size);
-                std::vector<BENCH_DATA_TYPE>test_b(mat_size * mat_size);
-
-                for(size_t i = 0; i < mat_size; ++i)
-                    for(size_t j = 0; j < mat_size; ++j){
-                        test_a[i * mat_size + j] = ((BENCH_DATA_TYPE)i * j) / mat_size;
-                        test_b[i * mat_size + j] = ((BENCH_DATA_TYPE)i * j +1)  / mat_size;
-                        test[i*mat_size+j] = ((BENCH_DATA_TYPE)i * j +2) / mat_size;
-                    }
-                for(size_t i = 0; i < mat_size && verification_passed; ++i)
-                    for(size_t j = 0; j < mat_size && verification_passed; ++j){
-
-                        test[i*mat_size+j] *= values::beta;
-                        for(size_t k = 0; k < mat_size; k++) {
-                            test[i*mat_size+j] += values::alpha * test_a[i*mat_size + k] * test_b[k* mat_size + j];
-                        }
-                        verification_passed = almost_equal(result[{i, j}], test[(i*mat_size)+j], 1);
-
-                    }
-            });
-        }); */
-        QueueManager::sync();
-        return verification_passed;
+        const auto n = static_cast<size_t>(mat_size);
+        // The result overwrote the initial res, so the references are computed from the inputs rather than the buffers
+        const HostInput<BENCH_DATA_TYPE> a(n, n, args.getInputFile(0), generators::Affine<BENCH_DATA_TYPE>{0, 0, 0, (BENCH_DATA_TYPE)n});
+        const HostInput<BENCH_DATA_TYPE> b(n, n, args.getInputFile(1), generators::Affine<BENCH_DATA_TYPE>{0, 0, 1, (BENCH_DATA_TYPE)n});
+        const HostInput<BENCH_DATA_TYPE> c(n, n, args.getInputFile(2), generators::Affine<BENCH_DATA_TYPE>{0, 0, 2, (BENCH_DATA_TYPE)n});
+        return verifyPartitions(QueueManager::getInstance(), mat_res_buf.get(), ver,
+            [&](size_t row_begin, size_t row_end, size_t col_begin, size_t col_end, BENCH_DATA_TYPE* out) {
+                host_reference::gemm(row_begin, row_end, col_begin, col_end, n, values::alpha, a.view(), b.view(), values::beta, c.view(), out);
+            }, VerificationTolerance{0, 1e-3});
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
+BENCHMARK_MAIN(gemm, app) {
     app.run< Gemm >();
 }
@@ -47,11 +47,6 @@ class Gesummv;
 
 class Gesummv {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_b;
-    std::vector<BENCH_DATA_TYPE> x;
-    std::vector<BENCH_DATA_TYPE> y;
-    std::vector<BENCH_DATA_TYPE> tmp;
     BenchmarkArgs args;
     int mat_size;
 
@@ -67,25 +62,12 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_b = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        x = std::vector<BENCH_DATA_TYPE>(mat_size);
-        y = std::vector<BENCH_DATA_TYPE>(mat_size,0.f);
-        tmp = std::vector<BENCH_DATA_TYPE>(mat_size, 0.f);
-
-        for(size_t i = 0; i < mat_size; i++) {
-            x[i] = ((BENCH_DATA_TYPE)i) / mat_size;
-
-            for(size_t j = 0; j < mat_size; j++) {
-                mat_a[i * mat_size + j] = ((BENCH_DATA_TYPE)i * j) / mat_size;
-                mat_b[i * mat_size + j] = ((BENCH_DATA_TYPE)i * j) / mat_size;
-            }
-        }
-
-        mat_a_buf.initialize(mat_a.data(), cl::sycl::range<2>(mat_size, mat_size));
-        mat_b_buf.initialize(mat_b.data(), cl::sycl::range<2>(mat_size, mat_size));
-        x_buffer.initialize(x.data(), cl::sycl::range<1>(mat_size));
-        y_buffer.initialize(y.data(), cl::sycl::range<1>(mat_size));
+        const auto init = generators::Affine<BENCH_DATA_TYPE>{0, 0, 0, (BENCH_DATA_TYPE)mat_size};
+        mat_a_buf.initialize(cl::sycl::range<2>(mat_size, mat_size), init);
+        mat_b_buf.initialize(cl::sycl::range<2>(mat_size, mat_size), init);
+        // x[i] = i / mat_size
+        x_buffer.initialize(cl::sycl::range<1>(mat_size), generators::Affine<BENCH_DATA_TYPE>{0, 1, 0, (BENCH_DATA_TYPE)mat_size});
+        y_buffer.initialize(cl::sycl::range<1>(mat_size), generators::Constant<BENCH_DATA_TYPE>{0});
         tmp_buf.initialize(cl::sycl::range<1>(mat_size));
     }
 
@@ -96,6 +78,8 @@ public:
                 tmp_buf.get(), mat_size);
     }
 
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Gesummv"; }
 
     bool verify(VerificationSetting &ver) {
@@ -122,8 +106,6 @@ public:
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
+BENCHMARK_MAIN(gesummv, app) {
     app.run< Gesummv >();
 }
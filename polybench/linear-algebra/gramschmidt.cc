@@ -22,7 +22,7 @@ void gramschmidt(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE,
         };
 
 #if BENCH_KERNEL == 1 || !defined( BENCH_KERNEL )
-        queue.submit([=](celerity::handler &cgh) {
+        KernelProfiler::submit(queue, "Gramschmidt1", [=](celerity::handler &cgh) {
             celerity::accessor A{mat_a, cgh, celerity::access::slice<2>(0), celerity::read_only};
             //celerity::accessor R{mat_r, cgh, non_empty_chunk_range_mapper, celerity::write_only, celerity::no_init};
             celerity::accessor R{mat_r, cgh, celerity::access::fixed<2>({{k, k}, {1, 1}}), celerity::write_only, celerity::no_init};
@@ -37,7 +37,7 @@ void gramschmidt(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE,
         });
 #endif
 #if BENCH_KERNEL == 2 || !defined( BENCH_KERNEL )
-        queue.submit([=](celerity::handler &cgh) {
+        KernelProfiler::submit(queue, "Gramschmidt2", [=](celerity::handler &cgh) {
             celerity::accessor A{mat_a, cgh, celerity::access::one_to_one{}, celerity::read_only};
             celerity::accessor R{mat_r, cgh, celerity::access::fixed<2>({{k, k}, {1, 1}}), celerity::read_only};
             celerity::accessor Q{mat_q, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
@@ -47,7 +47,7 @@ void gramschmidt(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE,
         });
 #endif
 #if BENCH_KERNEL == 3 || !defined( BENCH_KERNEL )
-        queue.submit([=](celerity::handler &cgh) {
+        KernelProfiler::submit(queue, "Gramschmidt3", [=](celerity::handler &cgh) {
             celerity::accessor A{mat_a, cgh, celerity::access::slice<2>(0), celerity::read_write};
             celerity::accessor R{mat_r, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
             celerity::accessor Q{mat_q, cgh, celerity::access::slice<2>(0), celerity::read_only};
@@ -73,11 +73,16 @@ void gramschmidt(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE,
 }
 
 
+// A random matrix with n added to its diagonal: well-conditioned, so that the factorization is stable in single precision
+struct DiagonallyDominant {
+    generators::Random<BENCH_DATA_TYPE> random;
+    BENCH_DATA_TYPE n;
+
+    BENCH_DATA_TYPE operator()(size_t i, size_t j) const { return random(i, j) + (i == j ? n : 0); }
+};
+
 class Gramschmidt {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_r;
-    std::vector<BENCH_DATA_TYPE> mat_q;
     BenchmarkArgs args;
     int mat_size;
 
@@ -91,39 +96,63 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_r = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_q = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-
-        for(size_t i = 0; i < mat_size; ++i) {
-            for(size_t j = 0; j < mat_size; ++j) {
-                mat_a[i * mat_size + j] = ((BENCH_DATA_TYPE)(i + 1) * (j + 1)) / (mat_size + 1);
-            }
-        }
-
-        mat_a_buf.initialize(mat_a.data(), celerity::range<2>(mat_size, mat_size));
-        mat_r_buf.initialize(celerity::range<2>(mat_size, mat_size));
+        mat_a_buf.initialize(celerity::range<2>(mat_size, mat_size), input());
+        // The kernels write the upper triangle of R only
+        mat_r_buf.initialize(celerity::range<2>(mat_size, mat_size), generators::Constant<BENCH_DATA_TYPE>{0});
         mat_q_buf.initialize(celerity::range<2>(mat_size, mat_size));
     }
 
+    DiagonallyDominant input() const { return {{args.seed, -1, 1}, (BENCH_DATA_TYPE)mat_size}; }
+
     void run() {
         gramschmidt(QueueManager::getInstance(),
                     mat_a_buf.get(),mat_r_buf.get(),
                     mat_q_buf.get(), mat_size);
     }
 
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Gramschmidt"; }
 
+#if !defined( BENCH_KERNEL )
+    // A single kernel of the chain reads intermediate results that no other kernel has written, so only the whole chain is verified
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        //TODO
-        QueueManager::sync();
-        return verification_passed;
+        const auto n = static_cast<size_t>(mat_size);
+        // Every column depends on all previous ones, so every node factorizes the whole matrix in the order of the kernels.
+        // A and Q are stored transposed to keep the loops over i contiguous.
+        auto a_t = makeHostMatrix<BENCH_DATA_TYPE>(n, n, [gen = input()](size_t j, size_t i) { return gen(i, j); });
+        auto q_t = makeHostVector<BENCH_DATA_TYPE>(n * n);
+        auto r = makeHostVector<BENCH_DATA_TYPE>(n * n);
+        for(size_t k = 0; k < n; k++) {
+            const BENCH_DATA_TYPE* a_k = &a_t[k * n];
+            BENCH_DATA_TYPE* q_k = &q_t[k * n];
+
+            BENCH_DATA_TYPE nrm = 0;
+            for(size_t i = 0; i < n; i++) nrm += a_k[i] * a_k[i];
+            r[k * n + k] = std::sqrt(nrm);
+
+            for(size_t i = 0; i < n; i++) q_k[i] = a_k[i] / r[k * n + k];
+
+            parallelFor(n - k - 1, [&](size_t c) {
+                const size_t j = k + 1 + c;
+                BENCH_DATA_TYPE* a_j = &a_t[j * n];
+                BENCH_DATA_TYPE R_result = 0;
+                for(size_t i = 0; i < n; i++) R_result += q_k[i] * a_j[i];
+                for(size_t i = 0; i < n; i++) a_j[i] -= q_k[i] * R_result;
+                r[k * n + j] = R_result;
+            }, std::max<size_t>(1, (1 << 14) / std::max<size_t>(1, n)));
+        }
+
+        // The entries of Q are at most 1 and those of R at most about n
+        const bool q_pass = verifyPartitions(QueueManager::getInstance(), mat_q_buf.get(), ver,
+            [&](size_t i, size_t j) { return q_t[j * n + i]; }, VerificationTolerance{1e-4, 1e-3});
+        const bool r_pass = verifyPartitions(QueueManager::getInstance(), mat_r_buf.get(), ver,
+            [&](size_t i, size_t j) { return r[i * n + j]; }, VerificationTolerance{2e-5 * n, 1e-3});
+        return q_pass && r_pass;
     }
+#endif
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
+BENCHMARK_MAIN(gramschmidt, app) {
     app.run< Gramschmidt >();
 }
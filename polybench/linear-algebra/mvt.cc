@@ -18,7 +18,7 @@ void mvt(celerity::distr_queue queue,
     using namespace cl::sycl;
     using namespace celerity::access;
 #if BENCH_KERNEL == 1 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Mvt1", [=](celerity::handler& cgh) {
         celerity::accessor a{mat_a, cgh, celerity::access::slice<2>(1), celerity::read_only};
         celerity::accessor y1{mat_y1, cgh, celerity::access::slice<2>(0), celerity::read_only};
         celerity::accessor x1{mat_x1, cgh, celerity::access::one_to_one{}, celerity::read_write};
@@ -33,7 +33,7 @@ void mvt(celerity::distr_queue queue,
 
 #endif
 #if BENCH_KERNEL == 2 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Mvt2", [=](celerity::handler& cgh) {
         celerity::accessor a{mat_a, cgh, celerity::access::slice<2>(0), celerity::read_only};
         celerity::accessor y2{mat_y2, cgh, celerity::access::slice<2>(0), celerity::read_only};
         celerity::accessor x2{mat_x2, cgh, celerity::access::one_to_one{}, celerity::read_write};
@@ -52,11 +52,11 @@ void mvt(celerity::distr_queue queue,
 
 class Mvt {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_x1;
-    std::vector<BENCH_DATA_TYPE> mat_x2;
-    std::vector<BENCH_DATA_TYPE> mat_y1;
-    std::vector<BENCH_DATA_TYPE> mat_y2;
+    HostVector<BENCH_DATA_TYPE> mat_a;
+    HostVector<BENCH_DATA_TYPE> mat_x1;
+    HostVector<BENCH_DATA_TYPE> mat_x2;
+    HostVector<BENCH_DATA_TYPE> mat_y1;
+    HostVector<BENCH_DATA_TYPE> mat_y2;
     BenchmarkArgs args;
     int mat_size;
 
@@ -72,17 +72,13 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_x1 = std::vector<BENCH_DATA_TYPE>(mat_size, 0);
-        mat_x2 = std::vector<BENCH_DATA_TYPE>(mat_size, 0);
-        mat_y1 = std::vector<BENCH_DATA_TYPE>(mat_size, 0);
-        mat_y2 = std::vector<BENCH_DATA_TYPE>(mat_size, 0);
-
-        for(size_t i = 0; i < mat_size; ++i) {
-            for(size_t j = 0; j < mat_size; ++j) {
-                mat_a[i * mat_size + j] = (BENCH_DATA_TYPE)(i + j + 1.0) / mat_size;
-            }
-        }
+        mat_a = makeHostMatrix<BENCH_DATA_TYPE>(mat_size, mat_size, [&](size_t i, size_t j) {
+            return (BENCH_DATA_TYPE)(i + j + 1.0) / mat_size;
+        });
+        mat_x1 = makeHostVector<BENCH_DATA_TYPE>(mat_size, 0);
+        mat_x2 = makeHostVector<BENCH_DATA_TYPE>(mat_size, 0);
+        mat_y1 = makeHostVector<BENCH_DATA_TYPE>(mat_size, 0);
+        mat_y2 = makeHostVector<BENCH_DATA_TYPE>(mat_size, 0);
 
         mat_a_buf.initialize(mat_a.data(),   celerity::range<2>(mat_size, mat_size));
         mat_x1_buf.initialize(mat_x1.data(), celerity::range<2>(mat_size, 1));
@@ -98,36 +94,38 @@ public:
                 mat_y2_buf.get(),mat_size);
     }
 
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Mvt"; }
 
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        /*QueueManager::getInstance().with_master_access([&](celerity::handler& cgh) {
-            auto result_x1 = mat_x1_buf.template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<2>(mat_size, 1));
-            auto result_x2 = mat_x2_buf.template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<2>(mat_size, 1));
-            cgh.run([=, &verification_passed]() {
-                std::vector<BENCH_DATA_TYPE> res_x1(mat_size, 0);
-                std::vector<BENCH_DATA_TYPE> res_x2(mat_size, 0);
-                for(size_t i = 0; i < mat_size && verification_passed; ++i)
-                    for(size_t j = 0; j < mat_size && verification_passed; ++j){
-                        for(size_t k = 0; k < mat_size; k++) {
-                            res_x1[i] += mat_a[(i*mat_size) + k] * mat_y1[k];
-                        }
-                        for(size_t k = 0; k < mat_size; k++) {
-                            res_x2[i] += mat_a[i*mat_size + k] * mat_y2[k];
-                        }
-                        verification_passed = res_x1[i] == result_x1[i][0];
-                        verification_passed = res_x2[i] == result_x2[i][0];
-                    }
-            });
-        });*/
-        QueueManager::sync();
-        return verification_passed;
+        const auto n = static_cast<size_t>(mat_size);
+        const host_reference::MatrixView<BENCH_DATA_TYPE> a{mat_a.data(), n};
+        // A kernel that is compiled out leaves its x at the initial value
+#if BENCH_KERNEL == 1 || !defined( BENCH_KERNEL )
+        const BENCH_DATA_TYPE x1_scale = 1;
+#else
+        const BENCH_DATA_TYPE x1_scale = 0;
+#endif
+#if BENCH_KERNEL == 2 || !defined( BENCH_KERNEL )
+        const BENCH_DATA_TYPE x2_scale = 1;
+#else
+        const BENCH_DATA_TYPE x2_scale = 0;
+#endif
+        // x1 += A * y1
+        const bool x1_pass = verifyPartitions(QueueManager::getInstance(), mat_x1_buf.get(), ver,
+            [&](size_t row_begin, size_t row_end, size_t, size_t, BENCH_DATA_TYPE* out) {
+                host_reference::gemv<BENCH_DATA_TYPE>(row_begin, row_end, n, x1_scale, a, mat_y1.data(), 1, mat_x1.data(), out);
+            }, VerificationTolerance{0, 1e-3});
+        // x2 += A^T * y2
+        const bool x2_pass = verifyPartitions(QueueManager::getInstance(), mat_x2_buf.get(), ver,
+            [&](size_t row_begin, size_t row_end, size_t, size_t, BENCH_DATA_TYPE* out) {
+                host_reference::gemv<BENCH_DATA_TYPE>(row_begin, row_end, n, x2_scale, a.transposed(), mat_y2.data(), 1, mat_x2.data(), out);
+            }, VerificationTolerance{0, 1e-3});
+        return x1_pass && x2_pass;
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
+BENCHMARK_MAIN(mvt, app) {
     app.run< Mvt >();
 }
@@ -13,9 +13,6 @@ class Syr2k;
 
 class Syr2k {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_b;
-    std::vector<BENCH_DATA_TYPE> mat_c;
     BenchmarkArgs args;
     int mat_size;
 
@@ -29,33 +26,23 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_b = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_c = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-
-        for(size_t i = 0; i < mat_size; ++i) {
-            for(size_t j = 0; j < mat_size; ++j) {
-                mat_a[(i * mat_size) + j] = ((BENCH_DATA_TYPE)i*j)/mat_size;
-                mat_b[(i * mat_size) + j] = ((BENCH_DATA_TYPE)i*j)/mat_size;
-                mat_c[(i * mat_size) + j] = ((BENCH_DATA_TYPE)i*j)/mat_size;
-            }
-        }
+        const auto init = generators::Affine<BENCH_DATA_TYPE>{0, 0, 0, (BENCH_DATA_TYPE)mat_size};
         auto range = celerity::range<2>(mat_size, mat_size);
-        mat_a_buf.initialize(mat_a.data(), range);
-        mat_b_buf.initialize(mat_b.data(), range);
-        mat_c_buf.initialize(mat_c.data(), range);
+        mat_a_buf.initialize(range, init);
+        mat_b_buf.initialize(range, init);
+        mat_c_buf.initialize(range, init);
     }
 
     void run() {
 #if BENCH_KERNEL == 1 || !defined( BENCH_KERNEL )
-        QueueManager::getInstance().submit([=](celerity::handler& cgh) {
+        KernelProfiler::submit(QueueManager::getInstance(), "Syr2k1", [=](celerity::handler& cgh) {
             celerity::accessor c{mat_c_buf.get(), cgh, celerity::access::one_to_one{}, celerity::read_write};
             cgh.parallel_for<class Syr2k1>(cl::sycl::range<2>(mat_size, mat_size), [=](celerity::item<2> item)
             { c[item] *= values::beta; });
         });
 #endif
 #if BENCH_KERNEL == 2 || !defined( BENCH_KERNEL )
-        QueueManager::getInstance().submit([=](celerity::handler& cgh) {
+        KernelProfiler::submit(QueueManager::getInstance(), "Syr2k2", [=](celerity::handler& cgh) {
             celerity::accessor A{mat_a_buf.get(), cgh, celerity::access::all{}, celerity::read_only};
             celerity::accessor B{mat_b_buf.get(), cgh, celerity::access::all{}, celerity::read_only};
             celerity::accessor C{mat_b_buf.get(), cgh, celerity::access::one_to_one{}, celerity::read_write};
@@ -73,6 +60,8 @@ public:
 #endif
     }
 
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Syr2k"; }
 
     bool verify(VerificationSetting &ver) {
@@ -96,8 +85,6 @@ public:
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
+BENCHMARK_MAIN(syr2k, app) {
     app.run< Syr2k >();
 }
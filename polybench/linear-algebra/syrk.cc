@@ -17,14 +17,14 @@ void syrk(
         const size_t mat_size
         ){
 #if BENCH_KERNEL == 1 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Syrk1", [=](celerity::handler& cgh) {
         celerity::accessor res{mat_res, cgh, celerity::access::one_to_one{}, celerity::read_write};
         cgh.parallel_for<class Syrk1>(cl::sycl::range<2>(mat_size, mat_size), [=](celerity::item<2> item)
         { res[item] *= values::beta; });
     });
 #endif
 #if BENCH_KERNEL == 2 || !defined( BENCH_KERNEL )
-    queue.submit([=](celerity::handler& cgh) {
+    KernelProfiler::submit(queue, "Syrk2", [=](celerity::handler& cgh) {
         celerity::accessor A{mat_a, cgh, celerity::access::all{}, celerity::read_only};
         celerity::accessor res{mat_res, cgh, celerity::access::one_to_one{}, celerity::read_write};
         cgh.parallel_for<class Syrk2>(celerity::range<2>(mat_size, mat_size), [=, n = mat_size](celerity::item<2> item) {
@@ -43,8 +43,6 @@ class Syrk;
 
 class Syrk {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_res;
     BenchmarkArgs args;
     int mat_size;
 
@@ -57,19 +55,10 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_res = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-
-        for(size_t i = 0; i < mat_size; ++i) {
-            for(size_t j = 0; j < mat_size; ++j) {
-                mat_a[(i * mat_size) + j] = ((BENCH_DATA_TYPE)i*j)/mat_size;
-                mat_res[(i * mat_size) + j] = ((BENCH_DATA_TYPE)i*j)/mat_size;
-            }
-        }
-
+        const auto init = generators::Affine<BENCH_DATA_TYPE>{0, 0, 0, (BENCH_DATA_TYPE)mat_size};
         auto range = celerity::range<2>(mat_size, mat_size);
-        mat_a_buf.initialize(mat_a.data(),    range);
-        mat_res_buf.initialize(mat_res.data(),range);
+        mat_a_buf.initialize(range, init);
+        mat_res_buf.initialize(range, init);
     }
 
     void run() {
@@ -77,29 +66,32 @@ public:
              mat_a_buf.get(), mat_res_buf.get(), mat_size);
     }
 
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Syrk"; }
 
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        /*QueueManager::getInstance().with_master_access([&](celerity::handler& cgh) {
-            auto result = mat_res_buf.template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<2>(mat_size, mat_size));
-            cgh.run([=, &verification_passed]() {
-                for(size_t i = 0; i < mat_size && verification_passed; ++i)
-                    for(size_t j = 0; j < mat_size && verification_passed; ++j) {
-                        auto test = mat_a[(i*mat_size)+j] * values::beta;
-                        for(size_t k = 0; k < mat_size; ++k)
-                            test += values::alpha * (mat_a[((i*mat_size)+k)] * mat_a[((j*mat_size)+k)]);
-                        verification_passed = almost_equal(result[{i, j}], test, 5);
-                    }
-            });
-        });*/
-        QueueManager::sync();
-        return verification_passed;
+        const auto n = static_cast<size_t>(mat_size);
+        // res starts out as a copy of A
+        const HostInput<BENCH_DATA_TYPE> a(n, n, nullptr, generators::Affine<BENCH_DATA_TYPE>{0, 0, 0, (BENCH_DATA_TYPE)n});
+        return verifyPartitions(QueueManager::getInstance(), mat_res_buf.get(), ver,
+            [&](size_t row_begin, size_t row_end, size_t col_begin, size_t col_end, BENCH_DATA_TYPE* out) {
+#if BENCH_KERNEL == 1
+                for(size_t i = row_begin; i < row_end; ++i)
+                    for(size_t j = col_begin; j < col_end; ++j)
+                        *out++ = values::beta * a.view()(i, j);
+#else
+#if BENCH_KERNEL == 2
+                const BENCH_DATA_TYPE beta = 1;
+#else
+                const BENCH_DATA_TYPE beta = values::beta;
+#endif
+                host_reference::gemm(row_begin, row_end, col_begin, col_end, n, values::alpha, a.view(), a.view().transposed(), beta, a.view(), out);
+#endif
+            }, VerificationTolerance{0, 1e-3});
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
-
+BENCHMARK_MAIN(syrk, app) {
     app.run< Syrk >();
 }
@@ -7,9 +7,9 @@ using BENCH_DATA_TYPE = float;
 
 class Adi {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_b;
-    std::vector<BENCH_DATA_TYPE> mat_res;
+    HostVector<BENCH_DATA_TYPE> mat_a;
+    HostVector<BENCH_DATA_TYPE> mat_b;
+    HostVector<BENCH_DATA_TYPE> mat_res;
     BenchmarkArgs args;
     int mat_size;
     PrefetchedBuffer<BENCH_DATA_TYPE, 2> mat_a_buf;
@@ -22,16 +22,15 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_b = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_res = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-
-        for (size_t i = 0; i < mat_size; i++)
-            for (size_t j = 0; j < mat_size; j++){
-                mat_a[(i*mat_size)+j]=((BENCH_DATA_TYPE) i*(j+1) + 1) / mat_size;
-                mat_b[(i*mat_size)+j]=((BENCH_DATA_TYPE) i*(j+2) + 2) / mat_size;
-                mat_res[(i*mat_size)+j]=((BENCH_DATA_TYPE) i*(j+3) + 3) / mat_size;
-            }
+        mat_a = makeHostMatrix<BENCH_DATA_TYPE>(mat_size, mat_size, [&](size_t i, size_t j) {
+            return ((BENCH_DATA_TYPE) i*(j+1) + 1) / mat_size;
+        });
+        mat_b = makeHostMatrix<BENCH_DATA_TYPE>(mat_size, mat_size, [&](size_t i, size_t j) {
+            return ((BENCH_DATA_TYPE) i*(j+2) + 2) / mat_size;
+        });
+        mat_res = makeHostMatrix<BENCH_DATA_TYPE>(mat_size, mat_size, [&](size_t i, size_t j) {
+            return ((BENCH_DATA_TYPE) i*(j+3) + 3) / mat_size;
+        });
 
         mat_a_buf.initialize(mat_a.data(), cl::sycl::range<2>(mat_size, mat_size));
         mat_b_buf.initialize(mat_b.data(), cl::sycl::range<2>(mat_size, mat_size));
@@ -78,6 +77,8 @@ public:
         QueueManager::sync();
     }
 
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Adi"; }
 
     bool verify(VerificationSetting &ver) {
@@ -100,7 +101,6 @@ public:
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(adi, app) {
     app.run< Adi >();
 }
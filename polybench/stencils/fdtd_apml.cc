@@ -71,7 +71,6 @@ public:
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(fdtd_apml, app) {
     app.run< Fdtd_apml >();
 }
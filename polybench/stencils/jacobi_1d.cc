@@ -8,11 +8,13 @@ using BENCH_DATA_TYPE = float;
 void jacobi(celerity::distr_queue queue,
             celerity::buffer<BENCH_DATA_TYPE, 1> mat_a, celerity::buffer<BENCH_DATA_TYPE, 1> mat_res,
             const size_t mat_size){
+    // No inner points to update
+    if(mat_size <= 2) return;
     queue.submit([=](celerity::handler& cgh) {
         celerity::accessor A{mat_a, cgh, celerity::access::neighborhood<1>(1), celerity::read_only};
         celerity::accessor RES{mat_res, cgh, celerity::access::neighborhood<1>(1), celerity::write_only, celerity::no_init};
 
-        cgh.parallel_for<class Jacobi_1d>(cl::sycl::range<1> (mat_size - 1), cl::sycl::id<1> {1}, [=](celerity::item<1> item) {
+        cgh.parallel_for<class Jacobi_1d>(cl::sycl::range<1> (mat_size - 2), cl::sycl::id<1> {1}, [=](celerity::item<1> item) {
             auto i = item[0];
             RES[i] =  0.33333 * (A[i-1] + A[i] + A[i + 1]);
         });
@@ -21,8 +23,6 @@ void jacobi(celerity::distr_queue queue,
 
 class Jacobi_1d {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_res;
     BenchmarkArgs args;
     int mat_size;
 
@@ -35,43 +35,44 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size);
-        mat_res = std::vector<BENCH_DATA_TYPE>(mat_size);
-
-        for (size_t i = 0; i < mat_size; i++){
-            mat_a[i] = ((BENCH_DATA_TYPE) i+ 2) / mat_size;
-            mat_res[i] = ((BENCH_DATA_TYPE) i+ 3) / mat_size;
-        }
-
+        // (i + 2) / mat_size and (i + 3) / mat_size
         auto range = celerity::range<1>(mat_size);
-        mat_a_buf.initialize(mat_a.data(), range);
-        mat_res_buf.initialize(mat_res.data(), range);
+        mat_a_buf.initialize(range, args.getInputFile(0), generators::Affine<BENCH_DATA_TYPE>{0, 1, 2, (BENCH_DATA_TYPE)mat_size});
+        mat_res_buf.initialize(range, args.getInputFile(1), generators::Affine<BENCH_DATA_TYPE>{0, 1, 3, (BENCH_DATA_TYPE)mat_size});
     }
 
     void run() {
         jacobi(QueueManager::getInstance(), mat_a_buf.get(), mat_res_buf.get(), mat_size);
     }
 
+    static RooflineMetric getRooflineMetric(const BenchmarkArgs& args) {
+        const double n = args.problem_size;
+        const double points = n > 2 ? n - 2 : 0;
+        // 2 adds and 1 multiply per inner point; reads A, writes the inner points of RES
+        return {3.0 * points, (n + points) * sizeof(BENCH_DATA_TYPE)};
+    }
+
     static std::string getBenchmarkName() { return "Jacobi_1d"; }
 
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        /*QueueManager::getInstance().with_master_access([&](celerity::handler& cgh) {
-            auto result = mat_res_buf.template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<1>(mat_size));
-            cgh.run([=, &verification_passed]() {
-                for(size_t i = 1; i < mat_size -1 && verification_passed; ++i){
-                        const float kernel_value = result[i];
-                        const float host_value =  0.33333 * (mat_a[i-1] + mat_a[i] + mat_a[i + 1]);
-                        verification_passed = almost_equal(kernel_value, host_value, 1.f);
-                    }
-            });
-        });*/
-        QueueManager::sync();
-        return verification_passed;
+        const auto n = static_cast<size_t>(mat_size);
+        // No inner points for n <= 2
+        const size_t inner = n > 2 ? n - 2 : 0;
+        const HostInput<BENCH_DATA_TYPE> a(n, 1, args.getInputFile(0), generators::Affine<BENCH_DATA_TYPE>{0, 1, 2, (BENCH_DATA_TYPE)n});
+        // A as a single column, so only the row offsets are weighted
+        const BENCH_DATA_TYPE weights[] = {
+            0, 0.33333f, 0,
+            0, 0.33333f, 0,
+            0, 0.33333f, 0,
+        };
+        // The kernel writes the inner points, which have their whole neighborhood inside A
+        return verifyPartitions(QueueManager::getInstance(), mat_res_buf.get(), ver, celerity::subrange<1>{{1}, {inner}},
+            [&](size_t row_begin, size_t row_end, size_t col_begin, size_t col_end, BENCH_DATA_TYPE* out) {
+                host_reference::stencil2d<1>(row_begin, row_end, col_begin, col_end, n, 1, a.data(), weights, out);
+            }, VerificationTolerance{0, 1e-5});
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(jacobi_1d, app) {
     app.run< Jacobi_1d >();
 }
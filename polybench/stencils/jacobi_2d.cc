@@ -11,11 +11,13 @@ void jacobi2d(
         celerity::buffer<BENCH_DATA_TYPE, 2> mat_res,
         const size_t mat_size
         ){
+        // No inner points to update
+        if(mat_size <= 2) return;
         queue.submit([=](celerity::handler& cgh) {
             celerity::accessor A{mat_a, cgh, celerity::access::neighborhood<2>(1,1), celerity::read_only};
             celerity::accessor RES{mat_res, cgh, celerity::access::neighborhood<2>(1,1), celerity::write_only, celerity::no_init};
 
-            cgh.parallel_for<class Jacobi_2d>(cl::sycl::range<2> (mat_size - 1, mat_size - 1), cl::sycl::id<2> {1,1}, [=](celerity::item<2> item) {
+            cgh.parallel_for<class Jacobi_2d>(cl::sycl::range<2> (mat_size - 2, mat_size - 2), cl::sycl::id<2> {1,1}, [=](celerity::item<2> item) {
                 auto i = item[0];
                 auto j = item[1];
                 RES[i][j] = 0.2 * (A[i][j] + A[i][j-1] + A[i][1+j] + A[1+i][j] + A[i-1][j]);
@@ -25,8 +27,6 @@ void jacobi2d(
 
 class Jacobi_2d {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
-    std::vector<BENCH_DATA_TYPE> mat_res;
     BenchmarkArgs args;
     int mat_size;
 
@@ -39,18 +39,9 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-        mat_res = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-
-        for (size_t i = 0; i < mat_size; i++)
-            for (size_t j = 0; j < mat_size; j++){
-                mat_a[(i*mat_size)+j] = ((BENCH_DATA_TYPE) i*(j+2) + 2) / mat_size;
-                mat_res[(i*mat_size)+j] = ((BENCH_DATA_TYPE) i*(j+3) + 3) / mat_size;
-            }
-
         auto range = cl::sycl::range<2>(mat_size, mat_size);
-        mat_a_buf.initialize(mat_a.data(), range);
-        mat_res_buf.initialize(mat_res.data(), range);
+        mat_a_buf.initialize(range, args.getInputFile(0), generators::Affine<BENCH_DATA_TYPE>{0, 2, 2, (BENCH_DATA_TYPE)mat_size});
+        mat_res_buf.initialize(range, args.getInputFile(1), generators::Affine<BENCH_DATA_TYPE>{0, 3, 3, (BENCH_DATA_TYPE)mat_size});
     }
 
     void run() {
@@ -59,29 +50,36 @@ public:
                  mat_res_buf.get(), mat_size);
     }
 
+    static RooflineMetric getRooflineMetric(const BenchmarkArgs& args) {
+        const double n = args.problem_size;
+        const double inner = n > 2 ? n - 2 : 0;
+        const double points = inner * inner;
+        // 4 adds and 1 multiply per inner point; reads A, writes the inner points of RES
+        return {5.0 * points, (n * n + points) * sizeof(BENCH_DATA_TYPE)};
+    }
+
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Jacobi_2d"; }
 
     bool verify(VerificationSetting &ver) {
-        bool verification_passed = true;
-        /* QueueManager::getInstance().with_master_access([&](celerity::handler& cgh) {
-            auto result = mat_res_buf.template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<2>(mat_size, mat_size));
-            cgh.run([=, &verification_passed]() {
-                for(size_t i = 1; i < mat_size -1; ++i)
-                    for(size_t j = 1; j < mat_size -1; ++j) {
-                        const float kernel_value = result[{i, j}];
-                        const float host_value = 0.2 * (mat_a[(i*mat_size)+j] + mat_a[(i*mat_size)+(j-1)]
-                                                        + mat_a[(i*mat_size)+(1+j)] + mat_a[((i+1)*mat_size)+j]
-                                                        + mat_a[((i-1)*mat_size)+j]);
-                        verification_passed = almost_equal(kernel_value, host_value, 1.f);
-                    }
-            });
-        });*/
-        QueueManager::sync();
-        return verification_passed;
+        const auto n = static_cast<size_t>(mat_size);
+        // No inner points for n <= 2
+        const size_t inner = n > 2 ? n - 2 : 0;
+        const HostInput<BENCH_DATA_TYPE> a(n, n, args.getInputFile(0), generators::Affine<BENCH_DATA_TYPE>{0, 2, 2, (BENCH_DATA_TYPE)n});
+        const BENCH_DATA_TYPE weights[] = {
+            0,    0.2f, 0,
+            0.2f, 0.2f, 0.2f,
+            0,    0.2f, 0,
+        };
+        // The kernel writes the inner points, which have their whole neighborhood inside A
+        return verifyPartitions(QueueManager::getInstance(), mat_res_buf.get(), ver, celerity::subrange<2>{{1, 1}, {inner, inner}},
+            [&](size_t row_begin, size_t row_end, size_t col_begin, size_t col_end, BENCH_DATA_TYPE* out) {
+                host_reference::stencil2d<1>(row_begin, row_end, col_begin, col_end, n, n, a.data(), weights, out);
+            }, VerificationTolerance{0, 1e-5});
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(jacobi_2d, app) {
     app.run< Jacobi_2d >();
 }
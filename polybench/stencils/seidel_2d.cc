@@ -22,7 +22,6 @@ void seidel(celerity::distr_queue queue,
 
 class Seidel {
 protected:
-    std::vector<BENCH_DATA_TYPE> mat_a;
     BenchmarkArgs args;
     int mat_size;
 
@@ -34,14 +33,8 @@ public:
     }
 
     void setup() {
-        mat_a = std::vector<BENCH_DATA_TYPE>(mat_size * mat_size);
-
-        for (size_t i = 0; i < mat_size; i++)
-            for (size_t j = 0; j < mat_size; j++)
-                mat_a[(i*mat_size)+j] = ((BENCH_DATA_TYPE) i*(j+2) + 2) / mat_size;
-
         auto range = celerity::range<2>(mat_size, mat_size);
-        mat_a_buf.initialize(mat_a.data(), range);
+        mat_a_buf.initialize(range, args.getInputFile(0), generators::Affine<BENCH_DATA_TYPE>{0, 2, 2, (BENCH_DATA_TYPE)mat_size});
 
     }
 
@@ -49,6 +42,15 @@ public:
         seidel(QueueManager::getInstance(), mat_a_buf.get(), mat_size);
     }
 
+    static RooflineMetric getRooflineMetric(const BenchmarkArgs& args) {
+        const double n = args.problem_size;
+        const double points = (n - 2) * (n - 2);
+        // 8 adds and 1 divide per inner point; A is read and its inner points are written back
+        return {9.0 * points, (n * n + points) * sizeof(BENCH_DATA_TYPE)};
+    }
+
+    static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
     static std::string getBenchmarkName() { return "Seidel"; }
 
     bool verify(VerificationSetting &ver) {
@@ -76,7 +78,6 @@ public:
     }
 };
 
-int main(int argc, char** argv) {
-    BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(seidel_2d, app) {
     app.run< Seidel >();
 }
@@ -3,68 +3,143 @@
 
 #include <common.h>
 #include <celerity.h>
+#include <matmul_variants.h>
+
+using BENCH_DATA_TYPE = float;
 
 // Performs matrix multiply
 
+template <typename Variant>
 class Matmul;
 
-// template <typename T>
-void set_identity(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE, 2> mat) {
+template <int TileSize>
+class MatmulTiledKernel;
+
+template <int Rows, int Cols, int KUnroll>
+class MatmulBlockedKernel;
+
+//template <typename T>
+void multiply(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE, 2> mat_a, celerity::buffer<BENCH_DATA_TYPE, 2> mat_b, celerity::buffer<BENCH_DATA_TYPE, 2> mat_c, const size_t mat_size, matmul_variants::Naive) {
 	queue.submit([=](celerity::handler& cgh) {
-		celerity::accessor dw{mat, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
-		cgh.parallel_for<class set_identity_kernel>(mat.get_range(), [=](celerity::item<2> item) { dw[item] = item[0] == item[1]; });
+		celerity::accessor a{mat_a, cgh, celerity::access::slice<2>(1), celerity::read_only};
+		celerity::accessor b{mat_b, cgh, celerity::access::slice<2>(0), celerity::read_only};
+		celerity::accessor c{mat_c, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
+
+		cgh.parallel_for<Matmul<matmul_variants::Naive>>(celerity::range<2>(mat_size, mat_size), [=](celerity::item<2> item) {
+			BENCH_DATA_TYPE sum{};
+			for(size_t k = 0; k < mat_size; ++k) {
+				const auto a_ik = a[{item[0], k}];
+				const auto b_kj = b[{k, item[1]}];
+				sum += a_ik * b_kj;
+			}
+			c[item] = sum;
+		});
 	});
 }
 
-//template <typename T>
-void multiply(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE, 2> mat_a, celerity::buffer<BENCH_DATA_TYPE, 2> mat_b, celerity::buffer<BENCH_DATA_TYPE, 2> mat_c, const size_t mat_size) {
+#if CELERITY_FEATURE_LOCAL_ACCESSOR
+
+template <int TileSize>
+void multiply(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE, 2> mat_a, celerity::buffer<BENCH_DATA_TYPE, 2> mat_b, celerity::buffer<BENCH_DATA_TYPE, 2> mat_c, const size_t mat_size, matmul_variants::Tiled<TileSize>) {
 	queue.submit([=](celerity::handler& cgh) {
 		celerity::accessor a{mat_a, cgh, celerity::access::slice<2>(1), celerity::read_only};
 		celerity::accessor b{mat_b, cgh, celerity::access::slice<2>(0), celerity::read_only};
 		celerity::accessor c{mat_c, cgh, celerity::access::one_to_one{}, celerity::write_only, celerity::no_init};
 
-/* #if CELERITY_FEATURE_LOCAL_ACCESSOR
-
 		// Use local-memory tiling to avoid waiting on global memory too often
-		const size_t GROUP_SIZE = 8;
-		celerity::local_accessor<BENCH_DATA_TYPE, 2> scratch_a{{GROUP_SIZE, GROUP_SIZE}, cgh};
-		celerity::local_accessor<BENCH_DATA_TYPE, 2> scratch_b{{GROUP_SIZE, GROUP_SIZE}, cgh};
+		celerity::local_accessor<BENCH_DATA_TYPE, 2> scratch_a{{TileSize, TileSize}, cgh};
+		celerity::local_accessor<BENCH_DATA_TYPE, 2> scratch_b{{TileSize, TileSize}, cgh};
 
-		cgh.parallel_for<class Matmul>(celerity::nd_range<2>{{mat_size, mat_size}, {GROUP_SIZE, GROUP_SIZE}}, [=](celerity::nd_item<2> item) {
+		// Sizes that are no multiple of the tile are padded, with zeros outside of the matrices
+		const size_t padded_size = (mat_size + TileSize - 1) / TileSize * TileSize;
+		cgh.parallel_for<MatmulTiledKernel<TileSize>>(celerity::nd_range<2>{{padded_size, padded_size}, {TileSize, TileSize}}, [=](celerity::nd_item<2> item) {
 			BENCH_DATA_TYPE sum{};
 			const auto lid = item.get_local_id();
-			for(size_t j = 0; j < mat_size; j += GROUP_SIZE) {
-				scratch_a[lid] = a[item.get_group(0) * GROUP_SIZE + lid[0]][j + lid[1]];
-				scratch_b[lid] = b[j + lid[0]][item.get_group(1) * GROUP_SIZE + lid[1]];
+			const auto gid = item.get_global_id();
+			for(size_t j = 0; j < mat_size; j += TileSize) {
+				scratch_a[lid] = gid[0] < mat_size && j + lid[1] < mat_size ? a[{gid[0], j + lid[1]}] : BENCH_DATA_TYPE{};
+				scratch_b[lid] = j + lid[0] < mat_size && gid[1] < mat_size ? b[{j + lid[0], gid[1]}] : BENCH_DATA_TYPE{};
 				celerity::group_barrier(item.get_group());
 
-				for(size_t k = 0; k < GROUP_SIZE; ++k) {
+				for(size_t k = 0; k < TileSize; ++k) {
 					const auto a_ik = scratch_a[lid[0]][k];
 					const auto b_kj = scratch_b[k][lid[1]];
 					sum += a_ik * b_kj;
 				}
 				celerity::group_barrier(item.get_group());
 			}
-			c[item.get_global_id()] = sum;
+			if(gid[0] < mat_size && gid[1] < mat_size) {
+				c[gid] = sum;
+			}
 		});
+	});
+}
 
-#else */
+#endif
 
-		cgh.parallel_for<class Matmul>(celerity::range<2>(mat_size, mat_size), [=](celerity::item<2> item) {
-			BENCH_DATA_TYPE sum{};
-			for(size_t k = 0; k < mat_size; ++k) {
-				const auto a_ik = a[{item[0], k}];
-				const auto b_kj = b[{k, item[1]}];
-				sum += a_ik * b_kj;
+template <int Rows, int Cols, int KUnroll>
+void multiply(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE, 2> mat_a, celerity::buffer<BENCH_DATA_TYPE, 2> mat_b, celerity::buffer<BENCH_DATA_TYPE, 2> mat_c, const size_t mat_size, matmul_variants::Blocked<Rows, Cols, KUnroll>) {
+	queue.submit([=](celerity::handler& cgh) {
+		// Work-item (i, j) reads the rows i * Rows... of a and the columns j * Cols... of b and writes their block of c
+		const auto block_rows = [=](celerity::chunk<2> chunk) -> celerity::subrange<2> {
+			const size_t begin = std::min(chunk.offset[0] * Rows, mat_size);
+			return {{begin, 0}, {std::min(chunk.range[0] * Rows, mat_size - begin), mat_size}};
+		};
+		const auto block_cols = [=](celerity::chunk<2> chunk) -> celerity::subrange<2> {
+			const size_t begin = std::min(chunk.offset[1] * Cols, mat_size);
+			return {{0, begin}, {mat_size, std::min(chunk.range[1] * Cols, mat_size - begin)}};
+		};
+		const auto blocks = [=](celerity::chunk<2> chunk) -> celerity::subrange<2> {
+			const auto rows = block_rows(chunk);
+			const auto cols = block_cols(chunk);
+			return {{rows.offset[0], cols.offset[1]}, {rows.range[0], cols.range[1]}};
+		};
+		celerity::accessor a{mat_a, cgh, block_rows, celerity::read_only};
+		celerity::accessor b{mat_b, cgh, block_cols, celerity::read_only};
+		celerity::accessor c{mat_c, cgh, blocks, celerity::write_only, celerity::no_init};
+
+		const celerity::range<2> num_blocks{(mat_size + Rows - 1) / Rows, (mat_size + Cols - 1) / Cols};
+		cgh.parallel_for<MatmulBlockedKernel<Rows, Cols, KUnroll>>(num_blocks, [=](celerity::item<2> item) {
+			const size_t i0 = item[0] * Rows;
+			const size_t j0 = item[1] * Cols;
+			BENCH_DATA_TYPE acc[Rows][Cols] = {};
+
+			// Blocks at the edge read the last row or column again in place of the missing ones, so
+			// that the inner blocks can load contiguous columns of b without any bounds checks
+			const auto accumulate = [&](auto at_edge) {
+				const auto row = [&](int r) { return decltype(at_edge)::value ? std::min(i0 + r, mat_size - 1) : i0 + r; };
+				const auto col = [&](int s) { return decltype(at_edge)::value ? std::min(j0 + s, mat_size - 1) : j0 + s; };
+				const auto step = [&](size_t k) {
+					BENCH_DATA_TYPE b_k[Cols];
+					for(int s = 0; s < Cols; ++s) b_k[s] = b[{k, col(s)}];
+					for(int r = 0; r < Rows; ++r) {
+						const auto a_rk = a[{row(r), k}];
+						for(int s = 0; s < Cols; ++s) acc[r][s] += a_rk * b_k[s];
+					}
+				};
+				size_t k = 0;
+				for(; k + KUnroll <= mat_size; k += KUnroll) {
+					for(int u = 0; u < KUnroll; ++u) step(k + u);
+				}
+				for(; k < mat_size; ++k) step(k);
+			};
+			if(i0 + Rows <= mat_size && j0 + Cols <= mat_size) {
+				accumulate(std::false_type{});
+			} else {
+				accumulate(std::true_type{});
 			}
-			c[item] = sum;
-		});
 
-// #endif
+			for(int r = 0; r < Rows; ++r) {
+				for(int s = 0; s < Cols; ++s) {
+					if(i0 + r < mat_size && j0 + s < mat_size) c[{i0 + r, j0 + s}] = acc[r][s];
+				}
+			}
+		});
 	});
 }
 
 
+template <typename Variant>
 class Matmul {
 protected:    
 	//std::vector<BENCH_DATA_TYPE> mat_a;
@@ -109,54 +184,52 @@ public:
     //  mat_a_buf.initialize  (celerity::range<2>(mat_size, mat_size));
     //  mat_b_buf.initialize  (celerity::range<2>(mat_size, mat_size));
 		//  mat_res_buf.initialize(celerity::range<2>(mat_size, mat_size));
-    mat_a_buf.initialize(range);
-    mat_b_buf.initialize(range);
+    mat_a_buf.initialize(range, args.getInputFile(0), inputA());
+    mat_b_buf.initialize(range, args.getInputFile(1), inputB());
 		mat_res_buf.initialize(range);
-    set_identity(QueueManager::getInstance(), mat_a_buf.get());
-    set_identity(QueueManager::getInstance(), mat_b_buf.get());
 	}
 
+	// Two different random matrices, so that verification catches kernels that swap or transpose a and b,
+	// which a product of identities would not
+	generators::Random<BENCH_DATA_TYPE> inputA() const { return {args.seed}; }
+	generators::Random<BENCH_DATA_TYPE> inputB() const { return {args.seed + 1}; }
+
 	//void run(celerity::distr_queue queue, celerity::buffer<BENCH_DATA_TYPE, 2> mat_a_buf, celerity::buffer<BENCH_DATA_TYPE, 2> mat_b_buf,
     //celerity::buffer<BENCH_DATA_TYPE, 2> mat_res_buf) {
 	void run() {
     //multiply(queue, mat_a_buf, mat_b_buf, mat_res_buf, mat_size);
-    multiply(QueueManager::getInstance(), mat_a_buf.get(), mat_b_buf.get(), mat_res_buf.get(), mat_size);
+    multiply(QueueManager::getInstance(), mat_a_buf.get(), mat_b_buf.get(), mat_res_buf.get(), mat_size, Variant{});
 	}
 
-	static std::string getBenchmarkName() { return "Matmul"; }
+	static ThroughputMetric getThroughputMetric(const BenchmarkArgs& args) {
+		const double n = args.problem_size;
+		// One multiply and one add per step of the n^2 dot products of length n
+		const double FLOP = 2.0 * n * n * n;
+		return {FLOP / 1024.0 / 1024.0 / 1024.0, std::is_same_v<BENCH_DATA_TYPE, double> ? "DP GFLOP" : "SP GFLOP"};
+	}
+
+	static RooflineMetric getRooflineMetric(const BenchmarkArgs& args) {
+		const double n = args.problem_size;
+		// n^2 dot products of length n (one multiply and one add each); reads a and b, writes c
+		return {2.0 * n * n * n, 3.0 * n * n * sizeof(BENCH_DATA_TYPE)};
+	}
+
+	static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
+	static std::string getBenchmarkName() { return "Matmul" + Variant::getSuffix(); }
 
 	bool verify(VerificationSetting &ver) {
-		bool verification_passed = true;
-		/*auto range = celerity::range<2>(mat_size, mat_size);
-
-		QueueManager::getInstance().submit(celerity::allow_by_ref, [&](celerity::handler& cgh) {
-			//auto result = mat_res_buf.template get_access<cl::sycl::access::mode::read>(cgh, celerity::range<2>(mat_size, mat_size));
-			celerity::accessor result{mat_res_buf.get(), cgh, celerity::access::one_to_one{}, celerity::read_only_host_task};
-			//auto result{mat_res_buf, cgh, celerity::access::one_to_one{}, celerity::read_only_host_task};
-
-			cgh.host_task(mat_res_buf.get().get_range(), [=, &verification_passed](celerity::partition<2> part) {
-			//cgh.host_task(range, [=, &verification_passed]() {
-
-				for(size_t i = 0; i < mat_size; ++i) {
-					for(size_t j = 0; j < mat_size; ++j) {
-						const float kernel_value = result[{i, j}];
-						const float host_value = i == j;
-						if(kernel_value != host_value) {
-							//fprintf(stderr, "VERIFICATION FAILED for element %ld,%ld: %f != %f\n", i, j, kernel_value, host_value);
-							verification_passed = false;
-							break;
-						}
-					}
-					if(!verification_passed) { break; }
-				}
-			});
-		});*/
-		QueueManager::sync();
-		return verification_passed;
+		const auto n = static_cast<size_t>(mat_size);
+		const HostInput<BENCH_DATA_TYPE> a(n, n, args.getInputFile(0), inputA());
+		const HostInput<BENCH_DATA_TYPE> b(n, n, args.getInputFile(1), inputB());
+		return verifyPartitions(QueueManager::getInstance(), mat_res_buf.get(), ver,
+		    [&](size_t row_begin, size_t row_end, size_t col_begin, size_t col_end, BENCH_DATA_TYPE* out) {
+			    host_reference::gemm<BENCH_DATA_TYPE>(row_begin, row_end, col_begin, col_end, n, 1, a.view(), b.view(), 0, {}, out);
+		    }, VerificationTolerance{1e-4, 1e-3});
 	}
 };
 
-int main(int argc, char** argv) {
+BENCHMARK_MAIN(matmul, app) {
   /*//celerity::distr_queue queue;
   int mat_size = 1024;
   auto range = celerity::range<2>(mat_size, mat_size);
@@ -167,18 +240,17 @@ int main(int argc, char** argv) {
   PrefetchedBuffer<BENCH_DATA_TYPE, 2> mat_b_buf;
   PrefetchedBuffer<BENCH_DATA_TYPE, 2> mat_res_buf;
   Matmul matmul(mat_size);
-    mat_a_buf.initialize(range);
-    mat_b_buf.initialize(range);
+    mat_a_buf.initialize(range, generators::Identity<BENCH_DATA_TYPE>{});
+    mat_b_buf.initialize(range, generators::Identity<BENCH_DATA_TYPE>{});
 		mat_res_buf.initialize(range);
-    set_identity(QueueManager::getInstance(), mat_a_buf.get());
-    set_identity(QueueManager::getInstance(), mat_b_buf.get());
   //set_identity(queue, mat_a_buf);
   //set_identity(queue, mat_b_buf);
   QueueManager::getInstance().slow_full_sync();
   matmul.run(QueueManager::getInstance(), mat_a_buf.get(), mat_b_buf.get(), mat_res_buf.get());
   QueueManager::getInstance().slow_full_sync();*/
-  BenchmarkApp app(argc, argv);
 	
-	app.run< Matmul >();
+	matmul_variants::forEachSelected(app, [&](auto variant) {
+		app.run< Matmul<decltype(variant)> >();
+	});
 	QueueManager::sync();
 }
@@ -198,6 +198,8 @@ public:
 }
 
 
+static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
 static std::string getBenchmarkName() {
     return "MedianFilter";
   }
@@ -205,11 +207,8 @@ static std::string getBenchmarkName() {
 }; // MedianFilterBench class
 
 
-int main(int argc, char** argv)
-{
-  BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(median, app) {
   app.run<MedianFilterBench>();  
-  return 0;
 }
 
 
@@ -159,9 +159,6 @@ public:
   }
 };
 
-int main(int argc, char** argv)
-{
-  BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(mol_dyn, app) {
   app.run<MolecularDynamicsBench>();  
-  return 0;
 }
@@ -158,13 +158,10 @@ public:
   }
 };
 
-int main(int argc, char** argv)
-{
-  BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(scalar_prod, app) {
   app.run<ScalarProdBench<int>>();
   app.run<ScalarProdBench<long long>>();
   app.run<ScalarProdBench<float>>();
   app.run<ScalarProdBench<double>>();
 
-  return 0;
 }
@@ -157,16 +157,15 @@ public:
   }
 
 
+  static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
   static std::string getBenchmarkName() { return "Sobel3"; }
 
 }; // SobelBench class
 
 
-int main(int argc, char** argv)
-{
-  BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(sobel, app) {
   app.run<SobelBench>();  
-  return 0;
 }
 
 
@@ -166,6 +166,8 @@ public:
 }
 
 
+static std::size_t getNumElements(const BenchmarkArgs& args) { return args.problem_size * args.problem_size; }
+
 static std::string getBenchmarkName() {
     return "Sobel5";
   }
@@ -175,11 +177,8 @@ static std::string getBenchmarkName() {
 
 
 
-int main(int argc, char** argv)
-{
-  BenchmarkApp app(argc, argv);
+BENCHMARK_MAIN(sobel5, app) {
   app.run<Sobel5Bench>();
-  return 0;
 }
 
 